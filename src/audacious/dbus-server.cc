@@ -17,12 +17,17 @@
  * the use of this software.
  */
 
+#include <string.h>
+
 #include <libaudcore/audstrings.h>
 #include <libaudcore/drct.h>
 #include <libaudcore/equalizer.h>
+#include <libaudcore/hook.h>
 #include <libaudcore/interface.h>
+#include <libaudcore/mainloop.h>
 #include <libaudcore/playlist.h>
 #include <libaudcore/plugins.h>
+#include <libaudcore/render.h>
 #include <libaudcore/runtime.h>
 #include <libaudcore/tuple.h>
 
@@ -63,6 +68,283 @@ static Index<PlaylistAddItem> strv_to_index (const char * const * strv)
     return index;
 }
 
+/* Change notification.  Clients connect to the signals below instead of
+ * polling; everything is driven from hooks and runs in the main thread. */
+
+struct PositionClient
+{
+    String name;
+    unsigned interval;
+    unsigned watch;
+};
+
+static GDBusInterfaceSkeleton * skeleton = nullptr;
+static bool hooks_added = false;
+
+static Index<PositionClient> position_clients;
+static QueuedFunc position_timer;
+static unsigned position_interval;
+static int last_time = -1;
+
+static QueuedFunc volume_timer;
+static bool volume_pending = false;
+static StereoVolume last_volume = {-1, -1};
+
+static Index<Playlist> scanning_lists;
+
+static const unsigned min_position_interval = 50; /* ms */
+static const int volume_delay = 100; /* ms */
+
+#define EMIT(name, ...) \
+ obj_audacious_emit_##name ((Obj *) skeleton, __VA_ARGS__)
+
+static void emit_position (void * = nullptr)
+{
+    int time = aud_drct_get_time ();
+
+    if (time != last_time)
+    {
+        EMIT (position_changed, time);
+        last_time = time;
+    }
+}
+
+static void update_position_timer ()
+{
+    unsigned interval = 0;
+    for (auto & client : position_clients)
+    {
+        if (! interval || client.interval < interval)
+            interval = client.interval;
+    }
+
+    if (! interval || ! aud_drct_get_playing () || aud_drct_get_paused ())
+    {
+        position_timer.stop ();
+        position_interval = 0;
+    }
+    else if (interval != position_interval || ! position_timer.running ())
+    {
+        position_timer.start (interval, emit_position, nullptr);
+        position_interval = interval;
+    }
+}
+
+static int find_position_client (const char * name)
+{
+    for (int i = 0; i < position_clients.len (); i ++)
+    {
+        if (! strcmp (position_clients[i].name, name))
+            return i;
+    }
+
+    return -1;
+}
+
+static void remove_position_client (int i)
+{
+    g_bus_unwatch_name (position_clients[i].watch);
+    position_clients.remove (i, 1);
+}
+
+static void position_client_vanished (GDBusConnection *, const char * name, void *)
+{
+    int i = find_position_client (name);
+    if (i >= 0)
+    {
+        remove_position_client (i);
+        update_position_timer ();
+    }
+}
+
+static void set_position_interval (GDBusConnection * bus, const char * name,
+ unsigned interval)
+{
+    int i = find_position_client (name);
+
+    if (! interval)
+    {
+        if (i >= 0)
+            remove_position_client (i);
+    }
+    else
+    {
+        interval = aud::max (interval, min_position_interval);
+
+        if (i >= 0)
+            position_clients[i].interval = interval;
+        else
+        {
+            unsigned watch = g_bus_watch_name_on_connection (bus, name,
+             G_BUS_NAME_WATCHER_FLAGS_NONE, nullptr, position_client_vanished,
+             nullptr, nullptr);
+
+            position_clients.append (String (name), interval, watch);
+        }
+    }
+
+    update_position_timer ();
+}
+
+static void emit_status (void *, void *)
+{
+    const char * status = "stopped";
+    if (aud_drct_get_playing ())
+        status = aud_drct_get_paused () ? "paused" : "playing";
+
+    EMIT (status_changed, status);
+
+    last_time = -1;
+    update_position_timer ();
+}
+
+static void emit_track (void *, void *)
+{
+    if (! aud_drct_get_ready ())
+        return;
+
+    String title = aud_drct_get_title ();
+    String filename = aud_drct_get_filename ();
+
+    EMIT (track_changed, aud_drct_get_position (), title ? title : "",
+     filename ? filename : "", aud_drct_get_length ());
+}
+
+static void seeked (void *, void *)
+{
+    last_time = -1;
+    emit_position ();
+}
+
+static void emit_volume (void *)
+{
+    volume_pending = false;
+
+    StereoVolume volume = aud_drct_get_volume ();
+    if (volume.left != last_volume.left || volume.right != last_volume.right)
+    {
+        EMIT (volume_changed, volume.left, volume.right);
+        last_volume = volume;
+    }
+}
+
+/* volume changes come in bursts while a slider is dragged */
+static void volume_changed (void *, void *)
+{
+    if (! volume_pending)
+    {
+        volume_timer.queue (volume_delay, emit_volume, nullptr);
+        volume_pending = true;
+    }
+}
+
+static void check_scanning (Playlist list)
+{
+    int i = scanning_lists.find (list);
+    bool scanning = list.scan_in_progress ();
+
+    if (scanning == (i >= 0))
+        return;
+
+    if (scanning)
+        scanning_lists.append (list);
+    else
+        scanning_lists.remove (i, 1);
+
+    EMIT (scan_progress, list.index (), scanning);
+}
+
+static void playlist_updated (void *, void *)
+{
+    int n_lists = Playlist::n_playlists ();
+
+    for (int i = 0; i < n_lists; i ++)
+    {
+        auto list = Playlist::by_index (i);
+        auto update = list.update_detail ();
+
+        if (update.level)
+        {
+            int count = list.n_entries () - update.before - update.after;
+            EMIT (playlist_updated, i, update.level, update.before, count);
+        }
+
+        check_scanning (list);
+    }
+
+    /* forget playlists that have been deleted */
+    for (int i = 0; i < scanning_lists.len ();)
+    {
+        if (scanning_lists[i].index () < 0)
+            scanning_lists.remove (i, 1);
+        else
+            i ++;
+    }
+}
+
+static void scan_complete (void *, void *)
+{
+    for (int i = 0; i < scanning_lists.len ();)
+    {
+        Playlist list = scanning_lists[i];
+        if (list.index () >= 0 && list.scan_in_progress ())
+            i ++;
+        else
+        {
+            scanning_lists.remove (i, 1);
+            if (list.index () >= 0)
+                EMIT (scan_progress, list.index (), false);
+        }
+    }
+}
+
+static const struct
+{
+    const char * name;
+    HookFunction func;
+}
+notify_hooks[] =
+{
+    {"playback begin", emit_status},
+    {"playback pause", emit_status},
+    {"playback unpause", emit_status},
+    {"playback stop", emit_status},
+    {"playback ready", emit_track},
+    {"title change", emit_track},
+    {"playback seek", seeked},
+    {"volume change", volume_changed},
+    {"playlist update", playlist_updated},
+    {"playlist scan complete", scan_complete}
+};
+
+static void notify_init ()
+{
+    for (auto & hook : notify_hooks)
+        hook_associate (hook.name, hook.func, nullptr);
+
+    hooks_added = true;
+}
+
+static void notify_cleanup ()
+{
+    if (hooks_added)
+    {
+        for (auto & hook : notify_hooks)
+            hook_dissociate (hook.name, hook.func);
+
+        hooks_added = false;
+    }
+
+    while (position_clients.len ())
+        remove_position_client (position_clients.len () - 1);
+
+    position_timer.stop ();
+    position_interval = 0;
+    volume_timer.stop ();
+    volume_pending = false;
+    scanning_lists.clear ();
+}
+
 static gboolean do_add (Obj * obj, Invoc * invoc, const char * file)
 {
     CURRENT.insert_entry (-1, file, Tuple (), false);
@@ -247,6 +529,13 @@ static gboolean do_length (Obj * obj, Invoc * invoc)
     return true;
 }
 
+static gboolean do_lock_profile (Obj * obj, Invoc * invoc, gboolean reset)
+{
+    String report = aud_lock_profile_report (reset);
+    FINISH2 (lock_profile, report ? (const char *) report : "");
+    return true;
+}
+
 static gboolean do_main_win_visible (Obj * obj, Invoc * invoc)
 {
     FINISH2 (main_win_visible, ! aud_get_headless_mode () && aud_ui_is_shown ());
@@ -446,6 +735,40 @@ static gboolean do_recording (Obj * obj, Invoc * invoc)
     return true;
 }
 
+static gboolean do_render (Obj * obj, Invoc * invoc, const char * filename,
+ const char * dest, int bits)
+{
+    RenderOptions options;
+    options.bits = bits;
+
+    FINISH2 (render, aud_render_add (filename, dest, options));
+    return true;
+}
+
+static gboolean do_render_cancel (Obj * obj, Invoc * invoc, int job)
+{
+    aud_render_cancel (job);
+    FINISH (render_cancel);
+    return true;
+}
+
+static gboolean do_render_status (Obj * obj, Invoc * invoc, int job)
+{
+    static const char * const states[] =
+     {"queued", "running", "finished", "failed", "cancelled"};
+
+    RenderStatus status;
+    if (! aud_render_get_status (job, status))
+    {
+        FINISH2 (render_status, "unknown", 0, -1, "");
+        return true;
+    }
+
+    FINISH2 (render_status, states[(int) status.state], status.time,
+     status.length, status.error ? status.error : "");
+    return true;
+}
+
 static gboolean do_repeat (Obj * obj, Invoc * invoc)
 {
     FINISH2 (repeat, aud_get_bool ("repeat"));
@@ -538,6 +861,14 @@ static gboolean do_set_eq_preamp (Obj * obj, Invoc * invoc, double preamp)
     return true;
 }
 
+static gboolean do_set_position_interval (Obj * obj, Invoc * invoc, unsigned interval)
+{
+    set_position_interval (g_dbus_method_invocation_get_connection (invoc),
+     g_dbus_method_invocation_get_sender (invoc), interval);
+    FINISH (set_position_interval);
+    return true;
+}
+
 static gboolean do_set_volume (Obj * obj, Invoc * invoc, int vl, int vr)
 {
     aud_drct_set_volume ({vl, vr});
@@ -792,6 +1123,7 @@ handlers[] =
     {"handle-info", (GCallback) do_info},
     {"handle-jump", (GCallback) do_jump},
     {"handle-length", (GCallback) do_length},
+    {"handle-lock-profile", (GCallback) do_lock_profile},
     {"handle-main-win-visible", (GCallback) do_main_win_visible},
     {"handle-new-playlist", (GCallback) do_new_playlist},
     {"handle-number-of-playlists", (GCallback) do_number_of_playlists},
@@ -818,6 +1150,9 @@ handlers[] =
     {"handle-quit", (GCallback) do_quit},
     {"handle-recording", (GCallback) do_recording},
     {"handle-record", (GCallback) do_record},
+    {"handle-render", (GCallback) do_render},
+    {"handle-render-cancel", (GCallback) do_render_cancel},
+    {"handle-render-status", (GCallback) do_render_status},
     {"handle-repeat", (GCallback) do_repeat},
     {"handle-reverse", (GCallback) do_reverse},
     {"handle-reverse-album", (GCallback) do_reverse_album},
@@ -829,6 +1164,7 @@ handlers[] =
     {"handle-set-eq", (GCallback) do_set_eq},
     {"handle-set-eq-band", (GCallback) do_set_eq_band},
     {"handle-set-eq-preamp", (GCallback) do_set_eq_preamp},
+    {"handle-set-position-interval", (GCallback) do_set_position_interval},
     {"handle-set-volume", (GCallback) do_set_volume},
     {"handle-show-about-box", (GCallback) do_show_about_box},
     {"handle-show-filebrowser", (GCallback) do_show_filebrowser},
@@ -858,8 +1194,6 @@ handlers[] =
 static GMainLoop * mainloop = nullptr;
 static unsigned owner_id = 0;
 
-static GDBusInterfaceSkeleton * skeleton = nullptr;
-
 static void name_acquired (GDBusConnection *, const char * name, void *)
 {
     AUDINFO ("Owned D-Bus name (%s) on session bus.\n", name);
@@ -915,7 +1249,10 @@ StartupType dbus_server_init ()
     mainloop = nullptr;
 
     if (owner_id)
+    {
         startup = StartupType::Server;
+        notify_init ();
+    }
     else
         startup = StartupType::Client;
 
@@ -937,6 +1274,8 @@ ERROR:
 
 void dbus_server_cleanup ()
 {
+    notify_cleanup ();
+
     if (owner_id)
     {
         g_bus_unown_name (owner_id);
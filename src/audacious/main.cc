@@ -50,6 +50,7 @@ static struct {
     int mainwin, show_jump_box;
     int headless, quit_after_play;
     int verbose;
+    int startup_timing;
     int gtk;
 } options;
 
@@ -77,6 +78,7 @@ static const struct {
     {"headless", 'H', & options.headless, N_("Start without a graphical interface")},
     {"quit-after-play", 'q', & options.quit_after_play, N_("Quit on playback stop")},
     {"verbose", 'V', & options.verbose, N_("Print debugging messages (may be used twice)")},
+    {"startup-timing", 'T', & options.startup_timing, N_("Print how long each stage of startup takes")},
 #if defined(USE_QT) && defined(USE_GTK)
     {"gtk", 'G', & options.gtk, N_("Run in GTK mode")},
 #endif
@@ -165,6 +167,7 @@ static bool parse_options (int argc, char * * argv)
     }
 
     aud_set_headless_mode (options.headless);
+    aud_set_startup_report (options.startup_timing);
 
     if (options.verbose >= 2)
         audlog::set_stderr_level (audlog::Debug);
@@ -34,6 +34,9 @@ struct commandhandler
 extern const struct commandhandler handlers[];
 extern ObjAudacious * dbus_proxy;
 
+void audtool_exit (int status);
+gboolean audtool_capture (const char * line);
+
 void audtool_report (const char * str, ...);
 void audtool_whine (const char * str, ...);
 void audtool_whine_args (const char * name, const char * str, ...);
@@ -129,6 +132,7 @@ void shutdown_audacious_server (int, char * *);
 void show_about_window (int, char * *);
 
 void get_version (int argc, char * * argv);
+void lock_profile (int argc, char * * argv);
 void plugin_is_enabled (int argc, char * * argv);
 void plugin_enable (int argc, char * * argv);
 void config_get (int argc, char * * argv);
@@ -143,5 +147,14 @@ void equalizer_set_eq_band (int argc, char * * argv);
 void equalizer_active (int argc, char * * argv);
 
 int check_args_playlist_pos (int argc, char * * argv);
+char * construct_uri (char * string);
+
+void render_file (int argc, char * * argv);
+void render_status (int argc, char * * argv);
+void render_wait (int argc, char * * argv);
+void render_cancel (int argc, char * * argv);
+
+void batch_run (int argc, char * * argv);
+void batch_run_json (int argc, char * * argv);
 
 #endif
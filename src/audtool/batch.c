@@ -0,0 +1,522 @@
+/*
+ * batch.c
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/*
+ * Batch mode reads commands from a file (or stdin), one per line with
+ * shell-style quoting, and runs them all over the same D-Bus connection.
+ *
+ * The per-song queries (playlist-song, playlist-song-filename, etc.) and the
+ * simple playback commands are pipelined: up to BATCH_WINDOW calls are sent
+ * before the first reply is awaited.  D-Bus delivers calls on one connection
+ * in order, so this does not change their effect.  Other commands wait for
+ * the pipelined calls to complete and then run as usual.  Output is always
+ * printed in the order of the input.
+ *
+ * In JSON mode, each command produces exactly one line of output:
+ *
+ *     {"line": 3, "command": "playlist-song", "status": 0, "output": ["..."]}
+ *
+ * where "status" is the exit code that the command would have had if run by
+ * itself.
+ */
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audtool.h"
+#include "wrappers.h"
+
+#define BATCH_WINDOW 64
+
+typedef enum {
+    QUERY_NONE,
+    QUERY_TITLE,
+    QUERY_FILENAME,
+    QUERY_LENGTH,
+    QUERY_LENGTH_SECONDS,
+    QUERY_LENGTH_FRAMES,
+    QUERY_FIELD,
+    QUERY_STATUS,
+    CALL_PLAY,
+    CALL_PAUSE,
+    CALL_PLAYPAUSE,
+    CALL_STOP,
+    CALL_ADVANCE,
+    CALL_REVERSE,
+    CALL_JUMP
+} BatchQuery;
+
+static const struct {
+    const char * name;
+    BatchQuery query;
+} pipelined[] = {
+    {"playlist-song", QUERY_TITLE},
+    {"playlist-song-filename", QUERY_FILENAME},
+    {"playlist-song-length", QUERY_LENGTH},
+    {"playlist-song-length-seconds", QUERY_LENGTH_SECONDS},
+    {"playlist-song-length-frames", QUERY_LENGTH_FRAMES},
+    {"playlist-tuple-data", QUERY_FIELD},
+    {"playback-status", QUERY_STATUS},
+    {"playback-play", CALL_PLAY},
+    {"playback-pause", CALL_PAUSE},
+    {"playback-playpause", CALL_PLAYPAUSE},
+    {"playback-stop", CALL_STOP},
+    {"playlist-advance", CALL_ADVANCE},
+    {"playlist-reverse", CALL_REVERSE},
+    {"playlist-jump", CALL_JUMP}
+};
+
+typedef struct {
+    int line;
+    int argc;
+    char * * argv;
+    const struct commandhandler * handler;
+    BatchQuery query;
+    gboolean done;
+    int status;
+    GString * output; /* one or more lines, each ending in '\n' */
+} BatchItem;
+
+static gboolean batch_json;
+static GString * batch_output;
+static jmp_buf * batch_jump;
+static int batch_status;
+
+static GQueue batch_queue = G_QUEUE_INIT;
+static int batch_outstanding;
+
+void audtool_exit (int status)
+{
+    if (! batch_jump)
+        exit (status);
+
+    batch_status = status;
+    longjmp (* batch_jump, 1);
+}
+
+gboolean audtool_capture (const char * line)
+{
+    if (! batch_output)
+        return FALSE;
+
+    g_string_append (batch_output, line);
+    g_string_append_c (batch_output, '\n');
+    return TRUE;
+}
+
+static const struct commandhandler * find_handler (const char * name)
+{
+    if (name[0] == '-' && name[1] == '-')
+        name += 2;
+
+    for (int i = 0; handlers[i].name; i ++)
+    {
+        if (! g_ascii_strcasecmp (handlers[i].name, name) &&
+         g_ascii_strcasecmp (handlers[i].name, "<sep>"))
+            return & handlers[i];
+    }
+
+    return NULL;
+}
+
+static BatchQuery find_query (const char * name)
+{
+    for (int i = 0; i < (int) G_N_ELEMENTS (pipelined); i ++)
+    {
+        if (! strcmp (pipelined[i].name, name))
+            return pipelined[i].query;
+    }
+
+    return QUERY_NONE;
+}
+
+static void append_json_string (GString * str, const char * text)
+{
+    g_string_append_c (str, '"');
+
+    for (const char * c = text; * c; c ++)
+    {
+        switch (* c)
+        {
+        case '"': g_string_append (str, "\\\""); break;
+        case '\\': g_string_append (str, "\\\\"); break;
+        case '\n': g_string_append (str, "\\n"); break;
+        case '\r': g_string_append (str, "\\r"); break;
+        case '\t': g_string_append (str, "\\t"); break;
+
+        default:
+            if ((unsigned char) * c < 0x20)
+                g_string_append_printf (str, "\\u%04x", (unsigned char) * c);
+            else
+                g_string_append_c (str, * c);
+        }
+    }
+
+    g_string_append_c (str, '"');
+}
+
+static void print_item (BatchItem * item)
+{
+    if (! batch_json)
+    {
+        g_print ("%s", item->output->str);
+        return;
+    }
+
+    GString * str = g_string_new (NULL);
+
+    g_string_append_printf (str, "{\"line\": %d, \"command\": ", item->line);
+    append_json_string (str, item->argv ? item->argv[0] : "");
+    g_string_append_printf (str, ", \"status\": %d, \"output\": [", item->status);
+
+    char * * lines = g_strsplit (item->output->str, "\n", -1);
+
+    /* the last element is the empty string after the final '\n' */
+    for (int i = 0; lines[i] && lines[i + 1]; i ++)
+    {
+        if (i)
+            g_string_append (str, ", ");
+
+        append_json_string (str, lines[i]);
+    }
+
+    g_string_append (str, "]}\n");
+    g_print ("%s", str->str);
+
+    g_strfreev (lines);
+    g_string_free (str, TRUE);
+}
+
+static void free_item (BatchItem * item)
+{
+    g_strfreev (item->argv);
+    g_string_free (item->output, TRUE);
+    g_slice_free (BatchItem, item);
+}
+
+/* prints and frees the completed items at the head of the queue */
+static void flush_queue (void)
+{
+    BatchItem * item;
+
+    while ((item = g_queue_peek_head (& batch_queue)) && item->done)
+    {
+        g_queue_pop_head (& batch_queue);
+        print_item (item);
+        free_item (item);
+    }
+
+    fflush (stdout);
+}
+
+/* waits until no more than <max> pipelined calls are outstanding */
+static void wait_for_calls (int max)
+{
+    while (batch_outstanding > max)
+    {
+        g_main_context_iteration (NULL, TRUE);
+        flush_queue ();
+    }
+}
+
+/* runs a command synchronously, catching any attempt to exit */
+static void run_handler (BatchItem * item)
+{
+    jmp_buf jump;
+
+    /* output is printed directly unless it is to be wrapped in JSON, so that
+     * long-running commands can show progress */
+    batch_output = batch_json ? item->output : NULL;
+    batch_jump = & jump;
+    batch_status = 0;
+
+    if (! setjmp (jump))
+        item->handler->handler (MIN (item->handler->args + 1, item->argc), item->argv);
+
+    batch_output = NULL;
+    batch_jump = NULL;
+
+    item->status = batch_status;
+    item->done = TRUE;
+}
+
+static void query_done (GObject * source, GAsyncResult * res, void * data)
+{
+    BatchItem * item = data;
+    ObjAudacious * proxy = OBJ_AUDACIOUS (source);
+    gboolean success = FALSE;
+
+    switch (item->query)
+    {
+    case QUERY_TITLE:
+    case QUERY_FILENAME:
+    case QUERY_STATUS:
+    {
+        char * str = NULL;
+
+        if (item->query == QUERY_TITLE)
+            obj_audacious_call_song_title_finish (proxy, & str, res, NULL);
+        else if (item->query == QUERY_FILENAME)
+        {
+            if (obj_audacious_call_song_filename_finish (proxy, & str, res, NULL))
+                str = entry_uri_to_filename (str);
+        }
+        else
+            obj_audacious_call_status_finish (proxy, & str, res, NULL);
+
+        if ((success = (str != NULL)))
+            g_string_append_printf (item->output, "%s\n", str);
+
+        g_free (str);
+        break;
+    }
+
+    case QUERY_LENGTH:
+    case QUERY_LENGTH_SECONDS:
+    case QUERY_LENGTH_FRAMES:
+    {
+        int length = -1;
+        obj_audacious_call_song_frames_finish (proxy, & length, res, NULL);
+
+        if ((success = (length >= 0)))
+        {
+            if (item->query == QUERY_LENGTH)
+                g_string_append_printf (item->output, "%d:%.2d\n",
+                 length / 60000, length / 1000 % 60);
+            else if (item->query == QUERY_LENGTH_SECONDS)
+                g_string_append_printf (item->output, "%d\n", length / 1000);
+            else
+                g_string_append_printf (item->output, "%d\n", length);
+        }
+
+        break;
+    }
+
+    case QUERY_FIELD:
+    {
+        GVariant * var = NULL;
+        obj_audacious_call_song_tuple_finish (proxy, & var, res, NULL);
+
+        char * str = entry_field_to_string (var);
+
+        if ((success = (str != NULL)))
+            g_string_append_printf (item->output, "%s\n", str);
+
+        g_free (str);
+        break;
+    }
+
+    default:
+    {
+        /* the result of these calls is not checked when run singly either */
+        GVariant * ret = g_dbus_proxy_call_finish (G_DBUS_PROXY (source), res, NULL);
+
+        if (ret)
+            g_variant_unref (ret);
+
+        success = TRUE;
+        break;
+    }
+    }
+
+    item->status = success ? 0 : 1;
+    item->done = TRUE;
+    batch_outstanding --;
+}
+
+/* sends a pipelined call; returns FALSE if the arguments must be checked (and
+ * complained about) by the regular handler */
+static gboolean start_query (BatchItem * item)
+{
+    int pos = 0;
+
+    if (item->query == QUERY_NONE)
+        return FALSE;
+
+    if (item->query == QUERY_FIELD)
+    {
+        if (item->argc < 3 || (pos = atoi (item->argv[2])) < 1)
+            return FALSE;
+    }
+    else if (item->query <= QUERY_LENGTH_FRAMES || item->query == CALL_JUMP)
+    {
+        if (item->argc < 2 || (pos = atoi (item->argv[1])) < 1)
+            return FALSE;
+    }
+
+    switch (item->query)
+    {
+    case QUERY_TITLE:
+        obj_audacious_call_song_title (dbus_proxy, pos - 1, NULL, query_done, item);
+        break;
+    case QUERY_FILENAME:
+        obj_audacious_call_song_filename (dbus_proxy, pos - 1, NULL, query_done, item);
+        break;
+    case QUERY_LENGTH:
+    case QUERY_LENGTH_SECONDS:
+    case QUERY_LENGTH_FRAMES:
+        obj_audacious_call_song_frames (dbus_proxy, pos - 1, NULL, query_done, item);
+        break;
+    case QUERY_FIELD:
+        obj_audacious_call_song_tuple (dbus_proxy, pos - 1, item->argv[1], NULL, query_done, item);
+        break;
+    case QUERY_STATUS:
+        obj_audacious_call_status (dbus_proxy, NULL, query_done, item);
+        break;
+    case CALL_PLAY:
+        obj_audacious_call_play (dbus_proxy, NULL, query_done, item);
+        break;
+    case CALL_PAUSE:
+        obj_audacious_call_pause (dbus_proxy, NULL, query_done, item);
+        break;
+    case CALL_PLAYPAUSE:
+        obj_audacious_call_play_pause (dbus_proxy, NULL, query_done, item);
+        break;
+    case CALL_STOP:
+        obj_audacious_call_stop (dbus_proxy, NULL, query_done, item);
+        break;
+    case CALL_ADVANCE:
+        obj_audacious_call_advance (dbus_proxy, NULL, query_done, item);
+        break;
+    case CALL_REVERSE:
+        obj_audacious_call_reverse (dbus_proxy, NULL, query_done, item);
+        break;
+    case CALL_JUMP:
+        obj_audacious_call_jump (dbus_proxy, pos - 1, NULL, query_done, item);
+        break;
+    default:
+        return FALSE;
+    }
+
+    batch_outstanding ++;
+    return TRUE;
+}
+
+static gboolean read_line (FILE * file, GString * line)
+{
+    int c;
+
+    g_string_truncate (line, 0);
+
+    while ((c = fgetc (file)) != EOF && c != '\n')
+        g_string_append_c (line, c);
+
+    return (c != EOF || line->len);
+}
+
+static void run_command (int line, const char * text)
+{
+    BatchItem * item = g_slice_new0 (BatchItem);
+    GError * error = NULL;
+
+    item->line = line;
+    item->output = g_string_new (NULL);
+
+    g_queue_push_tail (& batch_queue, item);
+
+    if (! g_shell_parse_argv (text, & item->argc, & item->argv, & error))
+    {
+        audtool_whine ("line %d: %s\n", line, error->message);
+        g_error_free (error);
+
+        item->status = 1;
+        item->done = TRUE;
+        flush_queue ();
+        return;
+    }
+
+    item->handler = find_handler (item->argv[0]);
+
+    if (! item->handler || item->handler->handler == batch_run ||
+     item->handler->handler == batch_run_json)
+    {
+        audtool_whine ("line %d: Unknown command \"%s\".\n", line, item->argv[0]);
+
+        item->status = 1;
+        item->done = TRUE;
+        flush_queue ();
+        return;
+    }
+
+    item->query = find_query (item->handler->name);
+
+    if (start_query (item))
+    {
+        wait_for_calls (BATCH_WINDOW - 1);
+        return;
+    }
+
+    /* preserve the order of side effects and output */
+    wait_for_calls (0);
+    flush_queue ();
+
+    run_handler (item);
+    flush_queue ();
+}
+
+static void batch_run_real (int argc, char * * argv, gboolean json)
+{
+    FILE * file = stdin;
+
+    if (argc >= 2 && strcmp (argv[1], "-"))
+    {
+        if (! (file = fopen (argv[1], "r")))
+        {
+            audtool_whine ("Cannot open %s.\n", argv[1]);
+            audtool_exit (1);
+        }
+    }
+
+    GString * line = g_string_new (NULL);
+    int number = 0;
+
+    batch_json = json;
+
+    while (read_line (file, line))
+    {
+        number ++;
+
+        const char * text = line->str;
+        while (g_ascii_isspace (* text))
+            text ++;
+
+        if (* text && * text != '#')
+            run_command (number, text);
+    }
+
+    wait_for_calls (0);
+    flush_queue ();
+
+    g_string_free (line, TRUE);
+
+    if (file != stdin)
+        fclose (file);
+}
+
+void batch_run (int argc, char * * argv)
+{
+    batch_run_real (argc, argv, FALSE);
+}
+
+void batch_run_json (int argc, char * * argv)
+{
+    batch_run_real (argc, argv, TRUE);
+}
@@ -33,7 +33,7 @@ void equalizer_get_eq (int argc, char * * argv)
     obj_audacious_call_get_eq_sync (dbus_proxy, & preamp, & var, NULL, NULL);
 
     if (! var || ! g_variant_is_of_type (var, G_VARIANT_TYPE ("ad")))
-        exit (1);
+        audtool_exit (1);
 
     audtool_report ("preamp = %.2f", preamp);
 
@@ -41,12 +41,16 @@ void equalizer_get_eq (int argc, char * * argv)
     const double * bands = g_variant_get_fixed_array (var, & nbands, sizeof (double));
 
     if (nbands != NUM_BANDS)
-        exit (1);
+        audtool_exit (1);
+
+    // build the whole line so that it goes through audtool_report()
+    GString * str = g_string_new (NULL);
 
     for (int i = 0; i < NUM_BANDS; i ++)
-        printf ("%.2f ", bands[i]);
+        g_string_append_printf (str, "%.2f ", bands[i]);
 
-    printf ("\n");
+    audtool_report ("%s", str->str);
+    g_string_free (str, TRUE);
     g_variant_unref (var);
 }
 
@@ -62,7 +66,7 @@ void equalizer_get_eq_band (int argc, char * * argv)
     if (argc < 2)
     {
         audtool_whine_args (argv[0], "<band>");
-        exit (1);
+        audtool_exit (1);
     }
 
     int band = atoi (argv[1]);
@@ -78,7 +82,7 @@ void equalizer_set_eq (int argc, char * * argv)
     {
         audtool_whine_args (argv[0], "<preamp> <band0> <band1> <band2> <band3> "
          "<band4> <band5> <band6> <band7> <band8> <band9>");
-        exit (1);
+        audtool_exit (1);
     }
 
     double preamp = atof (argv[1]);
@@ -97,7 +101,7 @@ void equalizer_set_eq_preamp (int argc, char * * argv)
     if (argc < 2)
     {
         audtool_whine_args (argv[0], "<preamp>");
-        exit (1);
+        audtool_exit (1);
     }
 
     double preamp = atof (argv[1]);
@@ -109,7 +113,7 @@ void equalizer_set_eq_band (int argc, char * * argv)
     if (argc < 3)
     {
         audtool_whine_args (argv[0], "<band> <value>");
-        exit (1);
+        audtool_exit (1);
     }
 
     int band = atoi (argv[1]);
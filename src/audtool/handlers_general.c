@@ -41,7 +41,7 @@ void set_volume (int argc, char * * argv)
     if (argc < 2)
     {
         audtool_whine_args (argv[0], "<level>");
-        exit (1);
+        audtool_exit (1);
     }
 
     int vol = atoi (argv[1]);
@@ -113,24 +113,45 @@ void get_version (int argc, char * * argv)
     obj_audacious_call_version_sync (dbus_proxy, & version, NULL, NULL);
 
     if (! version)
-        exit (1);
+        audtool_exit (1);
 
     audtool_report ("Audacious %s", version);
     g_free (version);
 }
 
+void lock_profile (int argc, char * * argv)
+{
+    gboolean reset = (argc >= 2 && ! g_ascii_strcasecmp (argv[1], "reset"));
+    char * report = NULL;
+
+    obj_audacious_call_lock_profile_sync (dbus_proxy, reset, & report, NULL, NULL);
+
+    if (! report)
+        audtool_exit (1);
+
+    if (! report[0])
+    {
+        audtool_whine ("lock profiling is not enabled in this build of Audacious.\n");
+        g_free (report);
+        audtool_exit (1);
+    }
+
+    audtool_report ("%s", g_strchomp (report));
+    g_free (report);
+}
+
 void plugin_is_enabled (int argc, char * * argv)
 {
     if (argc != 2)
     {
         audtool_whine_args (argv[0], "<plugin>");
-        exit (1);
+        audtool_exit (1);
     }
 
     gboolean enabled = FALSE;
     obj_audacious_call_plugin_is_enabled_sync (dbus_proxy, argv[1], & enabled, NULL, NULL);
 
-    exit (! enabled);
+    audtool_exit (! enabled);
 }
 
 void plugin_enable (int argc, char * * argv)
@@ -146,7 +167,7 @@ void plugin_enable (int argc, char * * argv)
     else
     {
         audtool_whine_args (argv[0], "<plugin> <on/off>");
-        exit (1);
+        audtool_exit (1);
     }
 
     obj_audacious_call_plugin_enable_sync (dbus_proxy, argv[1], enable, NULL, NULL);
@@ -157,7 +178,7 @@ void config_get (int argc, char * * argv)
     if (argc != 2)
     {
         audtool_whine_args (argv[0], "[<section>:]<name>");
-        exit (1);
+        audtool_exit (1);
     }
 
     const char * section = "";
@@ -182,7 +203,7 @@ void config_set (int argc, char * * argv)
     if (argc != 3)
     {
         audtool_whine_args (argv[0], "[<section>:]<name> <value>");
-        exit (1);
+        audtool_exit (1);
     }
 
     const char * section = "";
@@ -47,7 +47,7 @@ void playback_playing (int argc, char * * argv)
     gboolean playing = FALSE;
     obj_audacious_call_playing_sync (dbus_proxy, & playing, NULL, NULL);
 
-    exit (! playing);
+    audtool_exit (! playing);
 }
 
 void playback_paused (int argc, char * * argv)
@@ -55,7 +55,7 @@ void playback_paused (int argc, char * * argv)
     gboolean paused = FALSE;
     obj_audacious_call_paused_sync (dbus_proxy, & paused, NULL, NULL);
 
-    exit (! paused);
+    audtool_exit (! paused);
 }
 
 void playback_stopped (int argc, char * * argv)
@@ -63,7 +63,7 @@ void playback_stopped (int argc, char * * argv)
     gboolean stopped = FALSE;
     obj_audacious_call_stopped_sync (dbus_proxy, & stopped, NULL, NULL);
 
-    exit (! stopped);
+    audtool_exit (! stopped);
 }
 
 void playback_status (int argc, char * * argv)
@@ -72,7 +72,7 @@ void playback_status (int argc, char * * argv)
     obj_audacious_call_status_sync (dbus_proxy, & status, NULL, NULL);
 
     if (! status)
-        exit (1);
+        audtool_exit (1);
 
     audtool_report ("%s", status);
     g_free (status);
@@ -83,7 +83,7 @@ void playback_seek (int argc, char * * argv)
     if (argc < 2)
     {
         audtool_whine_args (argv[0], "<position>");
-        exit (1);
+        audtool_exit (1);
     }
 
     obj_audacious_call_seek_sync (dbus_proxy, MAX (0, atof (argv[1]) * 1000), NULL, NULL);
@@ -94,7 +94,7 @@ void playback_seek_relative (int argc, char * * argv)
     if (argc < 2)
     {
         audtool_whine_args (argv[0], "<position>");
-        exit (1);
+        audtool_exit (1);
     }
 
     unsigned oldtime = 0;
@@ -112,5 +112,5 @@ void playback_recording (int argc, char * * argv)
     gboolean recording = FALSE;
     obj_audacious_call_recording_sync (dbus_proxy, & recording, NULL, NULL);
 
-    exit (! recording);
+    audtool_exit (! recording);
 }
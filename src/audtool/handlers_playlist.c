@@ -85,13 +85,13 @@ int check_args_playlist_pos (int argc, char * * argv)
     if (argc < 2 || (pos = atoi (argv[1])) < 1)
     {
         audtool_whine_args (argv[0], "<position>");
-        exit (1);
+        audtool_exit (1);
     }
 
     return pos;
 }
 
-static char * construct_uri (char * string)
+char * construct_uri (char * string)
 {
     char * filename = g_strdup (string);
     char * tmp, * path;
@@ -129,13 +129,13 @@ void playlist_add_url_string (int argc, char * * argv)
     if (argc < 2)
     {
         audtool_whine_args (argv[0], "<url>");
-        exit (1);
+        audtool_exit (1);
     }
 
     uri = construct_uri (argv[1]);
 
     if (! uri)
-        exit (1);
+        audtool_exit (1);
 
     obj_audacious_call_add_sync (dbus_proxy, uri, NULL, NULL);
     g_free (uri);
@@ -179,7 +179,7 @@ void set_current_playlist (int argc, char * * argv)
     if (argc < 2)
     {
         audtool_whine_args (argv[0], "<number>");
-        exit (1);
+        audtool_exit (1);
     }
 
     obj_audacious_call_set_active_playlist_sync (dbus_proxy, atoi (argv[1]) - 1, NULL, NULL);
@@ -191,7 +191,7 @@ void playlist_title (int argc, char * * argv)
     obj_audacious_call_get_active_playlist_name_sync (dbus_proxy, & title, NULL, NULL);
 
     if (! title)
-        exit (1);
+        audtool_exit (1);
 
     audtool_report ("%s", title);
     g_free (title);
@@ -202,7 +202,7 @@ void set_playlist_title (int argc, char * * argv)
     if (argc < 2)
     {
         audtool_whine_args (argv[0], "<title>");
-        exit (1);
+        audtool_exit (1);
     }
 
     obj_audacious_call_set_active_playlist_name_sync (dbus_proxy, argv[1], NULL, NULL);
@@ -339,7 +339,7 @@ void playlist_tuple_field_data (int argc, char * * argv)
     {
         audtool_whine_args (argv[0], "<fieldname> <position>");
         audtool_whine_tuple_fields ();
-        exit (1);
+        audtool_exit (1);
     }
 
     char * str = get_entry_field (pos - 1, argv[1]);
@@ -354,13 +354,13 @@ void playlist_ins_url_string (int argc, char * * argv)
     if (argc < 3 || (pos = atoi (argv[2])) < 1)
     {
         audtool_whine_args (argv[0], "<url> <position>");
-        exit (1);
+        audtool_exit (1);
     }
 
     char * uri = construct_uri (argv[1]);
 
     if (! uri)
-        exit (1);
+        audtool_exit (1);
 
     obj_audacious_call_playlist_ins_url_string_sync (dbus_proxy, uri, pos - 1, NULL, NULL);
 
@@ -372,13 +372,13 @@ void playlist_enqueue_to_temp (int argc, char * * argv)
     if (argc < 2)
     {
         audtool_whine_args (argv[0], "<url>");
-        exit (1);
+        audtool_exit (1);
     }
 
     char * uri = construct_uri (argv[1]);
 
     if (! uri)
-        exit (1);
+        audtool_exit (1);
 
     obj_audacious_call_playlist_enqueue_to_temp_sync (dbus_proxy, uri, NULL, NULL);
 
@@ -0,0 +1,120 @@
+/*
+ * handlers_render.c
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "audtool.h"
+#include "wrappers.h"
+
+static int check_args_job (int argc, char * * argv)
+{
+    int job;
+
+    if (argc < 2 || (job = atoi (argv[1])) < 1)
+    {
+        audtool_whine_args (argv[0], "<job>");
+        audtool_exit (1);
+    }
+
+    return job;
+}
+
+void render_file (int argc, char * * argv)
+{
+    int bits = 16, job = 0;
+
+    if (argc < 3 || (argc > 3 && (bits = atoi (argv[3])) != 16 && bits != 24 && bits != 32))
+    {
+        audtool_whine_args (argv[0], "<source> <destination> [16|24|32]");
+        audtool_exit (1);
+    }
+
+    char * source = construct_uri (argv[1]);
+    char * dest = construct_uri (argv[2]);
+
+    if (! source || ! dest)
+        audtool_exit (1);
+
+    obj_audacious_call_render_sync (dbus_proxy, source, dest, bits, & job, NULL, NULL);
+    g_free (source);
+    g_free (dest);
+
+    if (job < 1)
+        audtool_exit (1);
+
+    audtool_report ("%d", job);
+}
+
+void render_status (int argc, char * * argv)
+{
+    int job = check_args_job (argc, argv);
+    char * state = NULL, * error = NULL;
+    int time = 0, length = -1;
+
+    obj_audacious_call_render_status_sync (dbus_proxy, job, & state, & time,
+     & length, & error, NULL, NULL);
+
+    if (! state || ! error)
+        audtool_exit (1);
+
+    if (error[0])
+        audtool_report ("%s %d %d %s", state, time, length, error);
+    else
+        audtool_report ("%s %d %d", state, time, length);
+
+    g_free (state);
+    g_free (error);
+}
+
+/* exit code = 0 if the job finished successfully */
+void render_wait (int argc, char * * argv)
+{
+    int job = check_args_job (argc, argv);
+
+    while (1)
+    {
+        char * state = NULL, * error = NULL;
+        int time = 0, length = -1;
+
+        if (! obj_audacious_call_render_status_sync (dbus_proxy, job, & state,
+         & time, & length, & error, NULL, NULL))
+            audtool_exit (1);
+
+        gboolean running = ! strcmp (state, "queued") || ! strcmp (state, "running");
+        gboolean finished = ! strcmp (state, "finished");
+
+        if (! running && error[0])
+            audtool_whine ("%s\n", error);
+
+        g_free (state);
+        g_free (error);
+
+        if (! running)
+            audtool_exit (finished ? 0 : 1);
+
+        g_usleep (250000);
+    }
+}
+
+void render_cancel (int argc, char * * argv)
+{
+    int job = check_args_job (argc, argv);
+    obj_audacious_call_render_cancel_sync (dbus_proxy, job, NULL, NULL);
+}
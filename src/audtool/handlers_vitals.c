@@ -113,7 +113,7 @@ void get_current_song_tuple_field_data (int argc, char * * argv)
     {
         audtool_whine_args (argv[0], "<fieldname>");
         audtool_whine_tuple_fields();
-        exit (1);
+        audtool_exit (1);
     }
 
     char * str = get_entry_field (get_current_entry (), argv[1]);
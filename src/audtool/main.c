@@ -124,6 +124,12 @@ const struct commandhandler handlers[] =
     {"equalizer-get-band", equalizer_get_eq_band, "print gain of given equalizer band", 1},
     {"equalizer-set-band", equalizer_set_eq_band, "set gain of given equalizer band", 2},
 
+    {"<sep>", NULL, "Offline rendering", 0},
+    {"render-file", render_file, "render song to WAV file, print job number", 2},
+    {"render-status", render_status, "print state, time, and length of render job", 1},
+    {"render-wait", render_wait, "wait for render job; exit code = 0 on success", 1},
+    {"render-cancel", render_cancel, "cancel render job", 1},
+
     {"<sep>", NULL, "Miscellaneous", 0},
     {"mainwin-show", mainwin_show, "show/hide Audacious", 1},
     {"filebrowser-show", show_filebrowser, "show/hide Add Files window", 1},
@@ -132,12 +138,17 @@ const struct commandhandler handlers[] =
     {"about-show", show_about_window, "show/hide About window", 1},
 
     {"version", get_version, "print Audacious version", 0},
+    {"lock-profile", lock_profile, "print lock contention statistics ('reset' to clear)", 0},
     {"plugin-is-enabled", plugin_is_enabled, "exit code = 0 if plugin is enabled", 1},
     {"plugin-enable", plugin_enable, "enable/disable plugin", 2},
     {"config-get", config_get, "DO NOT USE", 1},
     {"config-set", config_set, "DO NOT USE", 2},
     {"shutdown", shutdown_audacious_server, "shut down Audacious", 0},
 
+    {"<sep>", NULL, "Batch mode", 0},
+    {"batch", batch_run, "run commands read from file (default: stdin)", 1},
+    {"batch-json", batch_run_json, "same as batch, with output in JSON", 1},
+
     {"help", get_handlers_list, "print this help", 0},
 
     {NULL, NULL, NULL, 0}
@@ -30,7 +30,9 @@ void audtool_report (const char * str, ...)
     buf = g_strdup_vprintf (str, va);
     va_end (va);
 
-    g_print ("%s\n", buf);
+    if (! audtool_capture (buf))
+        g_print ("%s\n", buf);
+
     g_free (buf);
 }
 
@@ -67,7 +69,7 @@ void audtool_whine_tuple_fields (void)
     obj_audacious_call_get_tuple_fields_sync (dbus_proxy, & fields, NULL, NULL);
 
     if (! fields)
-        exit (1);
+        audtool_exit (1);
 
     audtool_whine ("Field names include:\n");
 
@@ -35,7 +35,7 @@ void generic_on_off (int argc, char * * argv, OnOffFunc func)
     else
     {
         audtool_whine_args (argv[0], "<on/off>");
-        exit (1);
+        audtool_exit (1);
     }
 
     func (dbus_proxy, show, NULL, NULL);
@@ -47,7 +47,7 @@ int get_playlist_length (void)
     obj_audacious_call_length_sync (dbus_proxy, & length, NULL, NULL);
 
     if (length < 0)
-        exit (1);
+        audtool_exit (1);
 
     return length;
 }
@@ -58,7 +58,7 @@ int get_queue_length (void)
     obj_audacious_call_get_playqueue_length_sync (dbus_proxy, & length, NULL, NULL);
 
     if (length < 0)
-        exit (1);
+        audtool_exit (1);
 
     return length;
 }
@@ -69,7 +69,7 @@ int get_queue_entry (int qpos)
     obj_audacious_call_queue_get_list_pos_sync (dbus_proxy, qpos, & entry, NULL, NULL);
 
     if (entry == (unsigned) -1)
-        exit (1);
+        audtool_exit (1);
 
     return entry;
 }
@@ -80,7 +80,7 @@ int find_in_queue (int entry)
     obj_audacious_call_queue_get_queue_pos_sync (dbus_proxy, entry, & qpos, NULL, NULL);
 
     if (qpos == (unsigned) -1)
-        exit (1);
+        audtool_exit (1);
 
     return qpos;
 }
@@ -91,7 +91,7 @@ int get_current_entry (void)
     obj_audacious_call_position_sync (dbus_proxy, & entry, NULL, NULL);
 
     if (entry == (unsigned) -1)
-        exit (1);
+        audtool_exit (1);
 
     return entry;
 }
@@ -102,8 +102,13 @@ char * get_entry_filename (int entry)
     obj_audacious_call_song_filename_sync (dbus_proxy, entry, & uri, NULL, NULL);
 
     if (! uri)
-        exit (1);
+        audtool_exit (1);
 
+    return entry_uri_to_filename (uri);
+}
+
+char * entry_uri_to_filename (char * uri)
+{
     char * filename = g_filename_from_uri (uri, NULL, NULL);
 
     if (filename)
@@ -121,7 +126,7 @@ char * get_entry_title (int entry)
     obj_audacious_call_song_title_sync (dbus_proxy, entry, & title, NULL, NULL);
 
     if (! title)
-        exit (1);
+        audtool_exit (1);
 
     return title;
 }
@@ -132,7 +137,7 @@ int get_entry_length (int entry)
     obj_audacious_call_song_frames_sync (dbus_proxy, entry, & length, NULL, NULL);
 
     if (length < 0)
-        exit (1);
+        audtool_exit (1);
 
     return length;
 }
@@ -142,22 +147,32 @@ char * get_entry_field (int entry, const char * field)
     GVariant * var = NULL;
     obj_audacious_call_song_tuple_sync (dbus_proxy, entry, field, & var, NULL, NULL);
 
-    if (! var || ! g_variant_is_of_type (var, G_VARIANT_TYPE_VARIANT))
-        exit (1);
+    char * str = entry_field_to_string (var);
 
-    GVariant * var2 = g_variant_get_variant (var);
+    if (! str)
+        audtool_exit (1);
 
-    if (! var2)
-        exit (1);
+    return str;
+}
 
-    char * str;
+char * entry_field_to_string (GVariant * var)
+{
+    if (! var)
+        return NULL;
+
+    if (! g_variant_is_of_type (var, G_VARIANT_TYPE_VARIANT))
+    {
+        g_variant_unref (var);
+        return NULL;
+    }
+
+    GVariant * var2 = g_variant_get_variant (var);
+    char * str = NULL;
 
     if (g_variant_is_of_type (var2, G_VARIANT_TYPE_STRING))
         str = g_strdup (g_variant_get_string (var2, NULL));
     else if (g_variant_is_of_type (var2, G_VARIANT_TYPE_INT32))
         str = g_strdup_printf ("%d", (int) g_variant_get_int32 (var2));
-    else
-        exit (1);
 
     g_variant_unref (var);
     g_variant_unref (var2);
@@ -171,7 +186,7 @@ int get_current_time (void)
     obj_audacious_call_time_sync (dbus_proxy, & time, NULL, NULL);
 
     if (time == (unsigned) -1)
-        exit (1);
+        audtool_exit (1);
 
     return time;
 }
@@ -182,7 +197,7 @@ void get_current_info (int * bitrate_p, int * samplerate_p, int * channels_p)
     obj_audacious_call_get_info_sync (dbus_proxy, & bitrate, & samplerate, & channels, NULL, NULL);
 
     if (bitrate < 0 || samplerate < 0 || channels < 0)
-        exit (1);
+        audtool_exit (1);
 
     if (bitrate_p)
         * bitrate_p = bitrate;
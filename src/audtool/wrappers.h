@@ -37,6 +37,10 @@ char * get_entry_title (int entry);
 int get_entry_length (int entry);
 char * get_entry_field (int entry, const char * field);
 
+/* shared with the pipelined queries in batch.c */
+char * entry_uri_to_filename (char * uri); /* takes ownership of <uri> */
+char * entry_field_to_string (GVariant * var); /* unrefs <var> */
+
 int get_current_time (void);
 void get_current_info (int * bitrate, int * samplerate, int * channels);
 
@@ -142,6 +142,10 @@ static void add_file(PlaylistAddItem && item, Playlist::FilterFunc filter,
     AUDINFO("Adding file: %s\n", (const char *)item.filename);
     status_update(item.filename, result->items.len());
 
+    /* If we open the file to identify the decoder, we can re-use the same
+     * handle to read metadata (including that of any subtunes). */
+    VFSFile file;
+
     /*
      * If possible, we'll wait until the file is added to the playlist to probe
      * it.  There are a couple of reasons why we might need to probe it now:
@@ -156,10 +160,6 @@ static void add_file(PlaylistAddItem && item, Playlist::FilterFunc filter,
      */
     if (!item.tuple.valid() && !is_subtune(item.filename))
     {
-        /* If we open the file to identify the decoder, we can re-use the same
-         * handle to read metadata. */
-        VFSFile file;
-
         if (!item.decoder)
         {
             if (aud_get_bool("slow_probe"))
@@ -203,7 +203,22 @@ static void add_file(PlaylistAddItem && item, Playlist::FilterFunc filter,
 
     int n_subtunes = item.tuple.get_n_subtunes();
 
-    if (n_subtunes)
+    if (n_subtunes && item.decoder && input_plugin_reads_subtunes(item.decoder))
+    {
+        /* The decoder can read all the subtunes in one go, so do that now
+         * rather than scanning each of them separately later. */
+        auto subtunes = aud_file_read_subtune_tags(item.filename, item.decoder,
+                                                   file, item.tuple);
+
+        for (auto & subtune : subtunes)
+        {
+            if (!filter || filter(subtune.filename, user))
+                add_file(std::move(subtune), filter, user, result, false);
+            else
+                result->filtered = true;
+        }
+    }
+    else if (n_subtunes)
     {
         for (int sub = 0; sub < n_subtunes; sub++)
         {
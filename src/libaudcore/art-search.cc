@@ -25,14 +25,35 @@
 
 #include "audstrings.h"
 #include "index.h"
+#include "multihash.h"
 #include "runtime.h"
+#include "threads.h"
+
+/* how long the search results for a folder are reused, in microseconds */
+#define FOLDER_CACHE_TIME 10000000
+#define FOLDER_CACHE_SIZE 64
 
 struct SearchParams
 {
-    String filename;
     Index<String> include, exclude;
+    int max_depth;
 };
 
+/* Results of searching a folder, which are the same for every file in it.
+ * They are cached by the pooled folder URI, the same string that playlist
+ * entries keep as their folder. */
+struct FolderImages
+{
+    String include, exclude; /* settings used for the search */
+    int depth;               /* recursion depth used for the search, or -1 */
+    int64_t time;            /* when the folder was searched */
+    Index<String> names;     /* images in the folder itself */
+    String found;            /* image matching the name filter, or null */
+};
+
+static aud::mutex mutex;
+static SimpleHash<String, FolderImages> folders;
+
 static bool has_front_cover_extension(const char * name)
 {
     const char * ext = strrchr(name, '.');
@@ -58,6 +79,13 @@ static bool cover_name_filter(const char * name, const Index<String> & keywords,
     return false;
 }
 
+static bool is_cover(const char * name, const SearchParams * params)
+{
+    return has_front_cover_extension(name) &&
+           cover_name_filter(name, params->include, true) &&
+           !cover_name_filter(name, params->exclude, false);
+}
+
 static String fileinfo_recursive_get_image(const char * path,
                                            const SearchParams * params,
                                            int depth)
@@ -68,34 +96,12 @@ static String fileinfo_recursive_get_image(const char * path,
 
     const char * name;
 
-    if (aud_get_bool("use_file_cover") && !depth)
-    {
-        /* Look for images matching file name */
-        while ((name = g_dir_read_name(d)))
-        {
-            StringBuf newpath = filename_build({path, name});
-
-            if (has_front_cover_extension(name) &&
-                same_basename(name, params->filename) &&
-                !g_file_test(newpath, G_FILE_TEST_IS_DIR))
-            {
-                g_dir_close(d);
-                return String(newpath);
-            }
-        }
-
-        g_dir_rewind(d);
-    }
-
     /* Search for files using filter */
     while ((name = g_dir_read_name(d)))
     {
         StringBuf newpath = filename_build({path, name});
 
-        if (has_front_cover_extension(name) &&
-            cover_name_filter(name, params->include, true) &&
-            !cover_name_filter(name, params->exclude, false) &&
-            !g_file_test(newpath, G_FILE_TEST_IS_DIR))
+        if (is_cover(name, params) && !g_file_test(newpath, G_FILE_TEST_IS_DIR))
         {
             g_dir_close(d);
             return String(newpath);
@@ -104,8 +110,7 @@ static String fileinfo_recursive_get_image(const char * path,
 
     g_dir_rewind(d);
 
-    if (aud_get_bool("recurse_for_cover") &&
-        depth < aud_get_int("recurse_for_cover_depth"))
+    if (depth < params->max_depth)
     {
         /* Descend into directories recursively. */
         while ((name = g_dir_read_name(d)))
@@ -130,6 +135,75 @@ static String fileinfo_recursive_get_image(const char * path,
     return String();
 }
 
+/* lists the images in the folder itself and searches it (and, if enabled, its
+ * subfolders) for one matching the name filter */
+static void search_folder(const char * path, FolderImages & images)
+{
+    SearchParams params = {str_list_to_index(images.include, ", "),
+                           str_list_to_index(images.exclude, ", "),
+                           images.depth};
+
+    GDir * d = g_dir_open(path, 0, nullptr);
+    if (!d)
+        return;
+
+    const char * name;
+
+    while ((name = g_dir_read_name(d)))
+    {
+        if (!has_front_cover_extension(name))
+            continue;
+
+        StringBuf newpath = filename_build({path, name});
+        if (g_file_test(newpath, G_FILE_TEST_IS_DIR))
+            continue;
+
+        images.names.append(String(name));
+
+        if (!images.found && is_cover(name, &params))
+            images.found = String(newpath);
+    }
+
+    g_dir_rewind(d);
+
+    if (!images.found && images.depth > 0)
+    {
+        /* Descend into directories recursively. */
+        while ((name = g_dir_read_name(d)))
+        {
+            StringBuf newpath = filename_build({path, name});
+
+            if (g_file_test(newpath, G_FILE_TEST_IS_DIR))
+            {
+                images.found =
+                    fileinfo_recursive_get_image(newpath, &params, 1);
+
+                if (images.found)
+                    break;
+            }
+        }
+    }
+
+    g_dir_close(d);
+}
+
+/* picks the image for the file <basename> in the folder at path <local> */
+static String pick_image(const FolderImages & images, const char * local,
+                         const char * basename)
+{
+    if (aud_get_bool("use_file_cover"))
+    {
+        /* Look for images matching file name */
+        for (const String & name : images.names)
+        {
+            if (same_basename(name, basename))
+                return String(filename_build({local, name}));
+        }
+    }
+
+    return images.found;
+}
+
 String art_search(const char * filename)
 {
     StringBuf local = uri_to_filename(filename);
@@ -140,14 +214,52 @@ String art_search(const char * filename)
     if (!elem)
         return String();
 
+    String basename(elem);
+    cut_path_element(local, elem - local);
+
+    const char * slash = strrchr(filename, '/');
+    const char * base = slash ? slash + 1 : filename;
+    String folder(str_copy(filename, base - filename));
+
     String include = aud_get_str("cover_name_include");
     String exclude = aud_get_str("cover_name_exclude");
+    int depth = aud_get_bool("recurse_for_cover")
+                    ? aud_get_int("recurse_for_cover_depth")
+                    : -1;
+    int64_t now = g_get_monotonic_time();
+    String image_local;
 
-    SearchParams params = {String(elem), str_list_to_index(include, ", "),
-                           str_list_to_index(exclude, ", ")};
+    auto mh = mutex.take();
+    FolderImages * images = folders.lookup(folder);
 
-    cut_path_element(local, elem - local);
+    if (images && images->include == include && images->exclude == exclude &&
+        images->depth == depth && now - images->time < FOLDER_CACHE_TIME)
+        image_local = pick_image(*images, local, basename);
+    else
+    {
+        /* search without holding the lock, so that scanner threads looking
+         * at other folders are not blocked by the disk access */
+        mh.unlock();
+
+        FolderImages found = {include, exclude, depth, now};
+        search_folder(local, found);
+        image_local = pick_image(found, local, basename);
+
+        mh.lock();
+
+        if (folders.n_items() >= FOLDER_CACHE_SIZE)
+            folders.clear();
+
+        folders.add(folder, std::move(found));
+    }
+
+    mh.unlock();
 
-    String image_local = fileinfo_recursive_get_image(local, &params, 0);
     return image_local ? String(filename_to_uri(image_local)) : String();
 }
+
+void art_search_cleanup()
+{
+    auto mh = mutex.take();
+    folders.clear();
+}
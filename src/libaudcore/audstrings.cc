@@ -20,6 +20,7 @@
 #include "audstrings.h"
 
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -83,6 +84,97 @@ static const char swap_case[256] =
 #define IS_SEP(c) ((c) == '/')
 #endif
 
+#define TO_LOWER(c) \
+    ((unsigned char)(c) + (((unsigned char)(c) - (unsigned)'A' < 26) << 5))
+
+/* Word-at-a-time string kernels.  These scan eight bytes per step instead of
+ * one and work on any platform, without the need to pick an instruction set at
+ * runtime.  An aligned load never crosses a page boundary, so it is safe to
+ * read past the terminator as long as it is within the same word; however,
+ * AddressSanitizer does not know this, so it is disabled for these functions. */
+
+#ifdef __GNUC__
+#define NO_ASAN __attribute__((no_sanitize_address))
+#else
+#define NO_ASAN
+#endif
+
+static constexpr uint64_t ones = 0x0101010101010101;
+static constexpr uint64_t highs = 0x8080808080808080;
+
+static inline bool is_aligned(const char * s) { return !((uintptr_t)s & 7); }
+
+static inline NO_ASAN uint64_t load_word(const char * s)
+{
+    uint64_t w;
+    memcpy(&w, s, sizeof w);
+    return w;
+}
+
+/* true if any byte of <w> is zero */
+static inline bool has_zero(uint64_t w) { return (w - ones) & ~w & highs; }
+
+/* converts the ASCII letters in <w> to lower case */
+static inline uint64_t fold_word(uint64_t w)
+{
+    uint64_t t = w & ~highs;
+    uint64_t upper = (t + 0x3f * ones) & ~(t + 0x25 * ones) & ~w & highs;
+    return w | (upper >> 2);
+}
+
+/* length of the common prefix of <a> and <b>, not including the terminator */
+static NO_ASAN int common_prefix(const char * a, const char * b)
+{
+    const char * start = a;
+
+    if (!(((uintptr_t)a ^ (uintptr_t)b) & 7))
+    {
+        for (; !is_aligned(a); a++, b++)
+        {
+            if (*a != *b || !*a)
+                return a - start;
+        }
+
+        for (;; a += 8, b += 8)
+        {
+            uint64_t w = load_word(a);
+            if (has_zero(w) || w != load_word(b))
+                break;
+        }
+    }
+
+    while (*a == *b && *a)
+        a++, b++;
+
+    return a - start;
+}
+
+static NO_ASAN bool is_ascii(const char * s)
+{
+    for (; !is_aligned(s); s++)
+    {
+        if (!*s)
+            return true;
+        if (*s & 0x80)
+            return false;
+    }
+
+    for (;; s += 8)
+    {
+        uint64_t w = load_word(s);
+        if ((w & highs) || has_zero(w))
+            break;
+    }
+
+    for (; *s; s++)
+    {
+        if (*s & 0x80)
+            return false;
+    }
+
+    return true;
+}
+
 /* strcmp() that handles nullptr safely */
 EXPORT int strcmp_safe(const char * a, const char * b, int len)
 {
@@ -95,14 +187,41 @@ EXPORT int strcmp_safe(const char * a, const char * b, int len)
 }
 
 /* ASCII version of strcasecmp, also handles nullptr safely */
-EXPORT int strcmp_nocase(const char * a, const char * b, int len)
+EXPORT NO_ASAN int strcmp_nocase(const char * a, const char * b, int len)
 {
     if (!a)
         return b ? -1 : 0;
     if (!b)
         return 1;
 
-    return len < 0 ? g_ascii_strcasecmp(a, b) : g_ascii_strncasecmp(a, b, len);
+    size_t n = (len < 0) ? (size_t)-1 : len;
+
+    /* compare a word at a time if both strings can be aligned at once */
+    if (!(((uintptr_t)a ^ (uintptr_t)b) & 7))
+    {
+        for (; n && !is_aligned(a); a++, b++, n--)
+        {
+            int ca = TO_LOWER(*a), cb = TO_LOWER(*b);
+            if (ca != cb || !ca)
+                return ca - cb;
+        }
+
+        for (; n >= 8; a += 8, b += 8, n -= 8)
+        {
+            uint64_t wa = load_word(a);
+            if (has_zero(wa) || fold_word(wa) != fold_word(load_word(b)))
+                break;
+        }
+    }
+
+    for (; n; a++, b++, n--)
+    {
+        int ca = TO_LOWER(*a), cb = TO_LOWER(*b);
+        if (ca != cb || !ca)
+            return ca - cb;
+    }
+
+    return 0;
 }
 
 /* strlen() if <len> is negative, otherwise strnlen() */
@@ -170,8 +289,21 @@ EXPORT void str_append_printf(StringBuf & str, const char * format, ...)
 EXPORT StringBuf str_vprintf(const char * format, va_list args)
 {
     StringBuf str(-1);
-    int len = vsnprintf(str, str.len(), format, args);
-    str.resize(len);
+
+    va_list args2;
+    va_copy(args2, args);
+    int len = vsnprintf(str, str.len(), format, args2);
+    va_end(args2);
+
+    /* too long for the stack, try again on the heap */
+    if (len >= str.len())
+    {
+        str.resize(len);
+        vsnprintf(str, len + 1, format, args);
+    }
+    else
+        str.resize(len);
+
     return str;
 }
 
@@ -180,8 +312,18 @@ EXPORT void str_append_vprintf(StringBuf & str, const char * format,
 {
     int len0 = str.len();
     str.resize(-1);
-    int len1 = vsnprintf(str + len0, str.len() - len0, format, args);
+    int avail = str.len() - len0;
+
+    va_list args2;
+    va_copy(args2, args);
+    int len1 = vsnprintf(str + len0, avail, format, args2);
+    va_end(args2);
+
     str.resize(len0 + len1);
+
+    /* too long for the stack, try again on the heap */
+    if (len1 >= avail)
+        vsnprintf(str + len0, len1 + 1, format, args);
 }
 
 EXPORT bool str_has_prefix_nocase(const char * str, const char * prefix)
@@ -248,32 +390,33 @@ EXPORT unsigned str_calc_hash(const char * s)
 
 EXPORT const char * strstr_nocase(const char * haystack, const char * needle)
 {
-    while (1)
-    {
-        const char * ap = haystack;
-        const char * bp = needle;
+    if (!needle[0])
+        return haystack;
 
-        while (1)
-        {
-            char a = *ap++;
-            char b = *bp++;
-
-            if (!b) /* all of needle matched */
-                return (char *)haystack;
-            if (!a) /* end of haystack reached */
-                return nullptr;
+    const char first[3] = {needle[0], SWAP_CASE(needle[0]), 0};
+    int rest = strlen(needle + 1);
 
-            if (a != b && a != SWAP_CASE(b))
-                break;
-        }
+    /* strpbrk() is vectorized in most C libraries, so let it skip ahead to
+     * each candidate match */
+    while ((haystack = strpbrk(haystack, first)))
+    {
+        if (!strcmp_nocase(haystack + 1, needle + 1, rest))
+            return haystack;
 
         haystack++;
     }
+
+    return nullptr;
 }
 
 EXPORT const char * strstr_nocase_utf8(const char * haystack,
                                        const char * needle)
 {
+    /* non-ASCII characters such as U+212A KELVIN SIGN can fold to ASCII, so
+     * the fast path is valid only if both strings are pure ASCII */
+    if (is_ascii(needle) && is_ascii(haystack))
+        return strstr_nocase(haystack, needle);
+
     while (1)
     {
         const char * ap = haystack;
@@ -827,6 +970,14 @@ EXPORT int str_compare(const char * ap, const char * bp)
     if (!bp)
         return 1;
 
+    /* skip the identical prefix quickly, but not into the middle of a number */
+    int skip = common_prefix(ap, bp);
+    while (skip && ap[skip - 1] >= '0' && ap[skip - 1] <= '9')
+        skip--;
+
+    ap += skip;
+    bp += skip;
+
     unsigned char a = *ap++, b = *bp++;
     for (; a || b; a = *ap++, b = *bp++)
     {
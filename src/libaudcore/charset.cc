@@ -24,8 +24,6 @@
 #include <iconv.h>
 #include <string.h>
 
-#include <new>
-
 #include <glib.h>
 
 #include "libguess/libguess.h"
@@ -46,17 +44,25 @@ EXPORT StringBuf str_convert(const char * str, int len,
         len = strlen(str);
 
     StringBuf buf(-1);
+    size_t inbytesleft, outbytesleft, ret;
+
+    while (1)
+    {
+        inbytesleft = len;
+        outbytesleft = buf.len();
+        ICONV_CONST char * in = (ICONV_CONST char *)str;
+        char * out = buf;
 
-    size_t inbytesleft = len;
-    size_t outbytesleft = buf.len();
-    ICONV_CONST char * in = (ICONV_CONST char *)str;
-    char * out = buf;
+        errno = 0;
+        ret = iconv(conv, &in, &inbytesleft, &out, &outbytesleft);
 
-    errno = 0;
-    size_t ret = iconv(conv, &in, &inbytesleft, &out, &outbytesleft);
+        if (ret != (size_t)-1 || errno != E2BIG)
+            break;
 
-    if (ret == (size_t)-1 && errno == E2BIG)
-        throw std::bad_alloc();
+        /* out of space on the stack, start over on the heap */
+        iconv(conv, nullptr, nullptr, nullptr, nullptr);
+        buf.resize(aud::max(buf.len(), len) * 2);
+    }
 
     iconv_close(conv);
 
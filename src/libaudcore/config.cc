@@ -48,6 +48,8 @@ static const char * const core_defaults[] = {
     "eqpreset_extension", "",
     "equalizer_active", "FALSE",
     "equalizer_bands", "0,0,0,0,0,0,0,0,0,0",
+    "equalizer_parametric", "FALSE",
+    "equalizer_parametric_bands", "",
     "equalizer_preamp", "0",
 
     /* info popup / info window */
@@ -74,6 +76,7 @@ static const char * const core_defaults[] = {
     "enable_clipping_prevention", "TRUE",
     "output_bit_depth", "-1",
     "output_buffer_size", "500",
+    "output_keep_open", "FALSE",
     "record", "FALSE",
     "record_stream", aud::numeric_string<(int) OutputStream::AfterReplayGain>::str,
     "replay_gain_mode", aud::numeric_string<(int) ReplayGainMode::Track>::str,
@@ -82,11 +85,14 @@ static const char * const core_defaults[] = {
     "software_volume_control", "FALSE",
     "sw_volume_left", "100",
     "sw_volume_right", "100",
+    "vis_shared_feed", "FALSE",
     "volume_delta", "5",
 
     /* playback */
     "album_shuffle", "FALSE",
     "no_playlist_advance", "FALSE",
+    "prefetch_mb", "32",
+    "prefetch_tracks", "0",
     "repeat", "FALSE",
     "shuffle", "FALSE",
     "step_size", "5",
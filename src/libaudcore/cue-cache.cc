@@ -18,77 +18,16 @@
  */
 
 #include "cue-cache.h"
-#include "multihash.h"
 #include "playlist-internal.h"
-#include "threads.h"
 
-enum NodeState
-{
-    NotLoaded,
-    Loading,
-    Loaded
-};
-
-struct CueCacheNode
-{
-    Index<PlaylistAddItem> items;
-    NodeState state = NotLoaded;
-    int refcount = 0;
-};
-
-static SimpleHash<String, CueCacheNode> cache;
-static aud::mutex mutex;
-static aud::condvar cond;
-
-CueCacheRef::CueCacheRef(const char * filename) : m_filename(filename)
-{
-    auto mh = mutex.take();
-
-    m_node = cache.lookup(m_filename);
-    if (!m_node)
-        m_node = cache.add(m_filename, CueCacheNode());
-
-    m_node->refcount++;
-}
+static ItemCache cache;
 
-CueCacheRef::~CueCacheRef()
+CueCacheRef::CueCacheRef(const char * filename) : ItemCacheRef(cache, filename)
 {
-    auto mh = mutex.take();
-
-    m_node->refcount--;
-    if (!m_node->refcount)
-        cache.remove(m_filename);
 }
 
-const Index<PlaylistAddItem> & CueCacheRef::load()
+void CueCacheRef::load_items(Index<PlaylistAddItem> & items)
 {
-    auto mh = mutex.take();
     String title; // not used
-
-    switch (m_node->state)
-    {
-    case NotLoaded:
-        // load the cuesheet in this thread
-        m_node->state = Loading;
-        mh.unlock();
-        playlist_load(m_filename, title, m_node->items);
-        mh.lock();
-
-        m_node->state = Loaded;
-        cond.notify_all();
-        break;
-
-    case Loading:
-        // wait for cuesheet to load in another thread
-        while (m_node->state != Loaded)
-            cond.wait(mh);
-
-        break;
-
-    case Loaded:
-        // cuesheet already loaded
-        break;
-    }
-
-    return m_node->items;
+    playlist_load(m_filename, title, items);
 }
@@ -20,22 +20,15 @@
 #ifndef LIBAUDCORE_CUE_CACHE_H
 #define LIBAUDCORE_CUE_CACHE_H
 
-#include "index.h"
-#include "tuple.h"
+#include "item-cache.h"
 
-struct CueCacheNode;
-
-class CueCacheRef
+class CueCacheRef : public ItemCacheRef
 {
 public:
     CueCacheRef(const char * filename);
-    ~CueCacheRef();
-
-    const Index<PlaylistAddItem> & load();
 
-private:
-    String m_filename;
-    CueCacheNode * m_node;
+protected:
+    void load_items(Index<PlaylistAddItem> & items);
 };
 
 #endif // LIBAUDCORE_CUE_CACHE_H
@@ -87,6 +87,7 @@ bool aud_drct_enable_record(bool enable);
 
 /* --- VOLUME CONTROL --- */
 
+// connect to the "volume change" hook to be notified of changes
 StereoVolume aud_drct_get_volume();
 void aud_drct_set_volume(StereoVolume volume);
 int aud_drct_get_volume_main();
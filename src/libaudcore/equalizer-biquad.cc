@@ -0,0 +1,273 @@
+/*
+ * equalizer-biquad.cc
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "equalizer.h"
+#include "internal.h"
+
+#include "audio.h"
+
+#include <math.h>
+#include <string.h>
+
+/* ISO 266 third-octave center frequencies (Hz) */
+static const float third_octaves[31] = {
+    20,   25,   31.5, 40,   50,   63,    80,    100,   125,  160, 200,
+    250,  315,  400,  500,  630,  800,   1000,  1250,  1600, 2000, 2500,
+    3150, 4000, 5000, 6300, 8000, 10000, 12500, 16000, 20000};
+
+/* octave center frequencies of the classic equalizer (Hz) */
+static const float octaves[10] = {31.25f, 62.5f, 125,  250,  500,
+                                  1000,   2000,  4000, 8000, 16000};
+
+/* Q values giving a bandwidth of one octave and one third octave */
+#define Q_OCTAVE 1.4142136f
+#define Q_THIRD_OCTAVE 4.3184727f
+
+/* four lanes, using the GCC/Clang vector extensions (SSE, NEON, etc.) */
+typedef float Vec __attribute__((vector_size(16)));
+
+static Vec load(const float * src)
+{
+    Vec v;
+    memcpy(&v, src, sizeof v);
+    return v;
+}
+
+static void store(float * dest, Vec v) { memcpy(dest, &v, sizeof v); }
+
+typedef int Mask __attribute__((vector_size(16)));
+
+/* {a, b, c, d} -> {a, a, b, c}; lane 0 is overwritten by the next input */
+static Vec shift_lanes(Vec v)
+{
+#ifdef __clang__
+    return __builtin_shufflevector(v, v, 0, 0, 1, 2);
+#else
+    return __builtin_shuffle(v, Mask{0, 0, 1, 2});
+#endif
+}
+
+/* lanes set in <mask> from <a>, others from <b> */
+static Vec select(Mask mask, Vec a, Vec b)
+{
+    return (Vec)((mask & (Mask)a) | (~mask & (Mask)b));
+}
+
+struct Coefs
+{
+    double b0, b1, b2, a1, a2;
+};
+
+/* biquad designs from Robert Bristow-Johnson's "Audio EQ Cookbook" */
+static Coefs design_band(const EqBand & band, int rate)
+{
+    double A = pow(10, band.gain / 40);
+    double w0 = 2 * M_PI * band.freq / rate;
+    double cw = cos(w0);
+    double alpha = sin(w0) / (2 * band.q);
+    double sqA = 2 * sqrt(A) * alpha;
+    double b0, b1, b2, a0, a1, a2;
+
+    switch (band.type)
+    {
+    case EqBandType::LowShelf:
+        b0 = A * ((A + 1) - (A - 1) * cw + sqA);
+        b1 = 2 * A * ((A - 1) - (A + 1) * cw);
+        b2 = A * ((A + 1) - (A - 1) * cw - sqA);
+        a0 = (A + 1) + (A - 1) * cw + sqA;
+        a1 = -2 * ((A - 1) + (A + 1) * cw);
+        a2 = (A + 1) + (A - 1) * cw - sqA;
+        break;
+
+    case EqBandType::HighShelf:
+        b0 = A * ((A + 1) + (A - 1) * cw + sqA);
+        b1 = -2 * A * ((A - 1) + (A + 1) * cw);
+        b2 = A * ((A + 1) + (A - 1) * cw - sqA);
+        a0 = (A + 1) - (A - 1) * cw + sqA;
+        a1 = 2 * ((A - 1) - (A + 1) * cw);
+        a2 = (A + 1) - (A - 1) * cw - sqA;
+        break;
+
+    default: /* Peaking */
+        b0 = 1 + alpha * A;
+        b1 = -2 * cw;
+        b2 = 1 - alpha * A;
+        a0 = 1 + alpha / A;
+        a1 = -2 * cw;
+        a2 = 1 - alpha / A;
+        break;
+    }
+
+    return {b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0};
+}
+
+void BiquadCascade::design(const Index<EqBand> & bands, double preamp,
+                           int rate)
+{
+    Index<Coefs> sections;
+
+    for (const EqBand & band : bands)
+    {
+        /* flat bands are skipped, as are bands the sample rate can't
+         * represent */
+        if (band.gain == 0 || band.q <= 0 || band.freq <= 0 ||
+            band.freq >= 0.49f * rate)
+            continue;
+
+        sections.append(design_band(band, rate));
+    }
+
+    m_groups.clear();
+    m_groups.insert(0, (sections.len() + lanes - 1) / lanes);
+
+    for (int i = 0; i < m_groups.len() * lanes; i++)
+    {
+        Group & group = m_groups[i / lanes];
+        int lane = i % lanes;
+
+        /* unused lanes pass the signal through unchanged */
+        Coefs c = (i < sections.len()) ? sections[i] : Coefs{1, 0, 0, 0, 0};
+
+        group.b0[lane] = c.b0;
+        group.b1[lane] = c.b1;
+        group.b2[lane] = c.b2;
+        group.a1[lane] = c.a1;
+        group.a2[lane] = c.a2;
+    }
+
+    m_gain = powf(10, preamp / 20);
+    m_rate = rate;
+    m_state.clear();
+}
+
+void BiquadCascade::reset(int channels)
+{
+    m_channels = channels;
+    m_state.clear();
+    m_state.insert(0, m_groups.len() * channels);
+}
+
+void BiquadCascade::take_coefs(BiquadCascade && source)
+{
+    int old_len = m_groups.len();
+    int new_len = source.m_groups.len();
+
+    m_groups = std::move(source.m_groups);
+    m_gain = source.m_gain;
+    m_rate = source.m_rate;
+
+    if (new_len == old_len || m_state.len() != old_len * m_channels)
+        return;
+
+    /* no audio is held in the pipeline between calls, so sections can be
+     * added or removed without a gap; the others keep their state */
+    Index<State> state;
+    state.insert(0, new_len * m_channels);
+
+    for (int channel = 0; channel < m_channels; channel++)
+    {
+        for (int g = 0; g < aud::min(old_len, new_len); g++)
+            state[channel * new_len + g] = m_state[channel * old_len + g];
+    }
+
+    m_state = std::move(state);
+}
+
+void BiquadCascade::process(float * data, int samples)
+{
+    if (m_state.len() != m_groups.len() * m_channels)
+        reset(m_channels);
+
+    int n_groups = m_groups.len();
+    int frames = samples / aud::max(m_channels, 1);
+
+    if (m_gain != 1)
+        audio_amplify(data, 1, samples, &m_gain);
+
+    for (int channel = 0; channel < m_channels; channel++)
+    {
+        /* each group runs over the whole buffer in turn, so that its state can
+         * be kept in registers */
+        for (int g = 0; g < n_groups; g++)
+        {
+            const Group & c = m_groups[g];
+            State & state = m_state[channel * n_groups + g];
+
+            Vec b0 = load(c.b0), b1 = load(c.b1), b2 = load(c.b2);
+            Vec a1 = load(c.a1), a2 = load(c.a2);
+            Vec z1 = load(state.z1), z2 = load(state.z2);
+            Vec in = {};
+
+            float * f = data + channel;
+
+            /* at step t, lane l filters frame t - l; the first and last
+             * (lanes - 1) steps update only the lanes that have a frame */
+            for (int t = 0; t < frames + lanes - 1; t++)
+            {
+                if (t < frames)
+                    in[0] = f[t * m_channels];
+
+                /* transposed direct form II, all lanes at once */
+                Vec y = b0 * in + z1;
+                Vec new_z1 = b1 * in - a1 * y + z2;
+                Vec new_z2 = b2 * in - a2 * y;
+
+                if (t >= lanes - 1 && t < frames)
+                {
+                    z1 = new_z1;
+                    z2 = new_z2;
+                }
+                else
+                {
+                    Mask active;
+                    for (int l = 0; l < lanes; l++)
+                        active[l] = (t - l >= 0 && t - l < frames) ? -1 : 0;
+
+                    z1 = select(active, new_z1, z1);
+                    z2 = select(active, new_z2, z2);
+                }
+
+                if (t >= lanes - 1)
+                    f[(t - (lanes - 1)) * m_channels] = y[lanes - 1];
+
+                /* each lane feeds the next one on the following step */
+                in = shift_lanes(y);
+            }
+
+            store(state.z1, z1);
+            store(state.z2, z2);
+        }
+    }
+}
+
+EXPORT Index<EqBand> aud_eq_graphic_bands(const double * gains, int n_bands)
+{
+    Index<EqBand> bands;
+
+    const float * freqs = (n_bands == 31) ? third_octaves : octaves;
+    float q = (n_bands == 31) ? Q_THIRD_OCTAVE : Q_OCTAVE;
+
+    if (n_bands != 10 && n_bands != 31)
+        return bands;
+
+    for (int i = 0; i < n_bands; i++)
+        bands.append(EqBand{EqBandType::Peaking, freqs[i], (float)gains[i], q});
+
+    return bands;
+}
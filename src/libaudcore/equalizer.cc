@@ -49,14 +49,7 @@ static const float CF[AUD_EQ_NBANDS] = {31.25f, 62.5f, 125,  250,  500,
 
 static aud::mutex mutex;
 static bool active;
-static int channels, rate;
-static float a[AUD_EQ_NBANDS][2]; /* A weights */
-static float b[AUD_EQ_NBANDS][2]; /* B weights */
-static float wqv[AUD_MAX_CHANNELS][AUD_EQ_NBANDS]
-                [2]; /* Circular buffer for W data */
-static float gv[AUD_MAX_CHANNELS]
-               [AUD_EQ_NBANDS]; /* Gain factor for each channel and band */
-static int K;                   /* Number of used EQ bands */
+static EqFilter filter;
 
 /* 2nd order band-pass filter design */
 static void bp2(float * a, float * b, float fc)
@@ -70,10 +63,8 @@ static void bp2(float * a, float * b, float fc)
     b[1] = -1.005f;
 }
 
-void eq_set_format(int new_channels, int new_rate)
+void EqFilter::set_format(int new_channels, int new_rate)
 {
-    auto mh = mutex.take();
-
     channels = new_channels;
     rate = new_rate;
 
@@ -90,10 +81,14 @@ void eq_set_format(int new_channels, int new_rate)
 
     /* Reset state */
     memset(wqv[0][0], 0, sizeof wqv);
+
+    if (parametric && cascade.rate() != rate)
+        cascade.design(param_bands, param_preamp, rate);
+
+    cascade.reset(channels);
 }
 
-static void eq_set_bands_real(aud::mutex::holder &, double preamp,
-                              double * values)
+void EqFilter::set_bands(double preamp, const double * values)
 {
     float adj[AUD_EQ_NBANDS];
 
@@ -105,14 +100,49 @@ static void eq_set_bands_real(aud::mutex::holder &, double preamp,
         for (int i = 0; i < AUD_EQ_NBANDS; i++)
             gv[c][i] = powf(10, adj[i] / 20) - 1;
     }
+
+    parametric = false;
 }
 
-void eq_filter(float * data, int samples)
+void EqFilter::set_parametric(Index<EqBand> && bands, double preamp,
+                              BiquadCascade && new_cascade)
 {
-    auto mh = mutex.take();
+    param_bands = std::move(bands);
+    param_preamp = preamp;
 
-    if (!active)
+    if (new_cascade.rate() != rate)
+        new_cascade.design(param_bands, param_preamp, rate);
+
+    cascade.take_coefs(std::move(new_cascade));
+    parametric = true;
+}
+
+void EqFilter::set_bands_from_config()
+{
+    double preamp = aud_get_double("equalizer_preamp");
+
+    if (aud_get_bool("equalizer_parametric"))
+    {
+        BiquadCascade new_cascade;
+        auto bands = aud_eq_get_parametric_bands();
+        new_cascade.design(bands, preamp, rate);
+        set_parametric(std::move(bands), preamp, std::move(new_cascade));
+    }
+    else
+    {
+        double values[AUD_EQ_NBANDS];
+        aud_eq_get_bands(values);
+        set_bands(preamp, values);
+    }
+}
+
+void EqFilter::process(float * data, int samples)
+{
+    if (parametric)
+    {
+        cascade.process(data, samples);
         return;
+    }
 
     for (int channel = 0; channel < channels; channel++)
     {
@@ -144,30 +174,68 @@ void eq_filter(float * data, int samples)
     }
 }
 
-static void eq_update(void *, void *)
+void eq_set_format(int new_channels, int new_rate)
 {
     auto mh = mutex.take();
+    filter.set_format(new_channels, new_rate);
+}
 
-    active = aud_get_bool("equalizer_active");
+void eq_filter(float * data, int samples)
+{
+    auto mh = mutex.take();
 
-    double values[AUD_EQ_NBANDS];
-    aud_eq_get_bands(values);
-    eq_set_bands_real(mh, aud_get_double("equalizer_preamp"), values);
+    if (active)
+        filter.process(data, samples);
+}
+
+static void eq_update(void *, void *)
+{
+    bool new_active = aud_get_bool("equalizer_active");
+    double preamp = aud_get_double("equalizer_preamp");
+
+    if (aud_get_bool("equalizer_parametric"))
+    {
+        auto bands = aud_eq_get_parametric_bands();
+
+        /* design the filters without blocking the audio thread */
+        auto mh = mutex.take();
+        int rate = filter.get_rate();
+        mh.unlock();
+
+        BiquadCascade cascade;
+        cascade.design(bands, preamp, rate);
+
+        mh.lock();
+        active = new_active;
+        filter.set_parametric(std::move(bands), preamp, std::move(cascade));
+    }
+    else
+    {
+        double values[AUD_EQ_NBANDS];
+        aud_eq_get_bands(values);
+
+        auto mh = mutex.take();
+        active = new_active;
+        filter.set_bands(preamp, values);
+    }
 }
 
+static const char * const update_hooks[] = {
+    "set equalizer_active", "set equalizer_preamp", "set equalizer_bands",
+    "set equalizer_parametric", "set equalizer_parametric_bands"};
+
 void eq_init()
 {
     eq_update(nullptr, nullptr);
-    hook_associate("set equalizer_active", eq_update, nullptr);
-    hook_associate("set equalizer_preamp", eq_update, nullptr);
-    hook_associate("set equalizer_bands", eq_update, nullptr);
+
+    for (const char * name : update_hooks)
+        hook_associate(name, eq_update, nullptr);
 }
 
 void eq_cleanup()
 {
-    hook_dissociate("set equalizer_active", eq_update);
-    hook_dissociate("set equalizer_preamp", eq_update);
-    hook_dissociate("set equalizer_bands", eq_update);
+    for (const char * name : update_hooks)
+        hook_dissociate(name, eq_update);
 }
 
 EXPORT void aud_eq_set_bands(const double values[AUD_EQ_NBANDS])
@@ -202,6 +270,49 @@ EXPORT double aud_eq_get_band(int band)
     return values[band];
 }
 
+EXPORT void aud_eq_set_parametric_bands(const Index<EqBand> & bands)
+{
+    Index<double> values;
+
+    for (int i = 0; i < aud::min(bands.len(), AUD_EQ_MAX_PARAM_BANDS); i++)
+    {
+        auto & band = bands[i];
+        values.append((int)band.type);
+        values.append(band.freq);
+        values.append(band.gain);
+        values.append(band.q);
+    }
+
+    StringBuf string = double_array_to_str(values.begin(), values.len());
+    aud_set_str("equalizer_parametric_bands", string);
+}
+
+EXPORT Index<EqBand> aud_eq_get_parametric_bands()
+{
+    Index<EqBand> bands;
+    String string = aud_get_str("equalizer_parametric_bands");
+    auto values = str_list_to_index(string, ",");
+
+    for (int i = 0; i + 3 < values.len(); i += 4)
+    {
+        int type = str_to_int(values[i]);
+        float freq = str_to_double(values[i + 1]);
+        float gain = str_to_double(values[i + 2]);
+        float q = str_to_double(values[i + 3]);
+
+        if (type < (int)EqBandType::Peaking ||
+            type > (int)EqBandType::HighShelf || freq <= 0 || q <= 0)
+            continue;
+
+        bands.append(EqBand{(EqBandType)type, freq, gain, q});
+
+        if (bands.len() == AUD_EQ_MAX_PARAM_BANDS)
+            break;
+    }
+
+    return bands;
+}
+
 EXPORT void aud_eq_apply_preset(const EqualizerPreset & preset)
 {
     double bands[AUD_EQ_NBANDS];
@@ -43,6 +43,36 @@ double aud_eq_get_band(int band);
 void aud_eq_apply_preset(const EqualizerPreset & preset);
 void aud_eq_update_preset(EqualizerPreset & preset);
 
+/* Parametric equalizer.  When "equalizer_parametric" is set in the config,
+ * the bands below are applied instead of the classic 10-band equalizer.  The
+ * preamp ("equalizer_preamp") applies in both modes.  Bands with zero gain
+ * are skipped, so a large band list with mostly flat bands is cheap. */
+
+#define AUD_EQ_MAX_PARAM_BANDS 64
+
+enum class EqBandType
+{
+    Peaking,
+    LowShelf,
+    HighShelf
+};
+
+struct EqBand
+{
+    EqBandType type;
+    float freq; /* center (or corner, for shelves) frequency in Hz */
+    float gain; /* dB */
+    float q;
+};
+
+void aud_eq_set_parametric_bands(const Index<EqBand> & bands);
+Index<EqBand> aud_eq_get_parametric_bands();
+
+/* Builds a graphic equalizer as a list of peaking bands, one per element of
+ * <gains> (in dB).  <n_bands> may be 10 (octave bands, as in the classic
+ * equalizer and its presets) or 31 (ISO third-octave bands). */
+Index<EqBand> aud_eq_graphic_bands(const double * gains, int n_bands);
+
 Index<EqualizerPreset> aud_eq_read_presets(const char * basename);
 bool aud_eq_write_presets(const Index<EqualizerPreset> & list,
                           const char * basename);
@@ -24,6 +24,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <thread>
+
 #include <glib.h> /* for g_qsort_with_data */
 
 static void do_fill(void * data, int len, aud::FillFunc fill_func)
@@ -231,6 +233,14 @@ EXPORT void IndexBase::sort(CompareFunc compare, int elemsize, void * userdata)
     g_qsort_with_data(m_data, m_len / elemsize, elemsize, compare, userdata);
 }
 
+EXPORT void IndexBase::run_parallel(void (*func)(void *), void * a,
+                                    void * b) // static
+{
+    std::thread thread(func, a);
+    func(b);
+    thread.join();
+}
+
 EXPORT int IndexBase::bsearch(const void * key, CompareFunc compare,
                               int elemsize, void * userdata) const
 {
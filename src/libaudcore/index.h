@@ -20,6 +20,8 @@
 #ifndef LIBAUDCORE_INDEX_H
 #define LIBAUDCORE_INDEX_H
 
+#include <string.h>
+
 #include <libaudcore/templates.h>
 
 /*
@@ -72,11 +74,151 @@ public:
     int bsearch(const void * key, CompareFunc search, int elemsize,
                 void * userdata) const;
 
+    // calls func(a) in a new thread and func(b) in the calling thread
+    static void run_parallel(void (*func)(void *), void * a, void * b);
+
 private:
     void * m_data;
     int m_len, m_size;
 };
 
+namespace aud
+{
+
+// Stable merge sort with an inlined comparison function.  Objects are moved
+// bitwise, under the same rules as Index.  Sorted runs are detected and merged
+// by plain copying, so (nearly) sorted input costs about N comparisons.
+template<class T, class F>
+class StableSort
+{
+public:
+    StableSort(F & compare, bool parallel)
+        : m_compare(compare), m_depth(parallel ? max_depth : 0)
+    {
+    }
+
+    void sort(T * data, int len)
+    {
+        if (len < 2)
+            return;
+
+        IndexBase buf;
+        buf.insert(0, len * sizeof(T)); // no fill
+        sort(data, (T *)buf.begin(), len, false, m_depth);
+        buf.clear(nullptr);
+    }
+
+private:
+    static constexpr int insertion_max = 12;
+    static constexpr int parallel_min = 32768;
+    static constexpr int max_depth = 2; // up to 4 threads
+
+    struct Part
+    {
+        StableSort * self;
+        T * data, *buf;
+        int len;
+        bool into_buf;
+        int depth;
+    };
+
+    static void move(T * to, const T * from, int len)
+    {
+        memcpy((void *)to, (const void *)from, len * sizeof(T));
+    }
+
+    void insertion_sort(T * data, int len)
+    {
+        for (int i = 1; i < len; i++)
+        {
+            if (m_compare(data[i - 1], data[i]) <= 0)
+                continue;
+
+            alignas(T) char tmp[sizeof(T)];
+            move((T *)tmp, data + i, 1);
+
+            int j = i - 1;
+            while (j > 0 && m_compare(*(T *)tmp, data[j - 1]) < 0)
+                j--;
+
+            memmove((void *)(data + j + 1), (const void *)(data + j),
+                    (i - j) * sizeof(T));
+            move(data + j, (T *)tmp, 1);
+        }
+    }
+
+    void merge(const T * a, int len_a, const T * b, int len_b, T * out)
+    {
+        if (m_compare(a[len_a - 1], b[0]) <= 0)
+        {
+            move(out, a, len_a);
+            move(out + len_a, b, len_b);
+            return;
+        }
+
+        const T * end_a = a + len_a;
+        const T * end_b = b + len_b;
+
+        while (a < end_a && b < end_b)
+        {
+            // take from <a> on ties to keep the sort stable
+            if (m_compare(*b, *a) < 0)
+                move(out++, b++, 1);
+            else
+                move(out++, a++, 1);
+        }
+
+        move(out, a, end_a - a);
+        move(out + (end_a - a), b, end_b - b);
+    }
+
+    // sorts data[0..len), leaving the result either in place or in buf
+    void sort(T * data, T * buf, int len, bool into_buf, int depth)
+    {
+        if (len <= insertion_max)
+        {
+            insertion_sort(data, len);
+            if (into_buf)
+                move(buf, data, len);
+            return;
+        }
+
+        int half = len / 2;
+
+        if (depth > 0 && len >= parallel_min)
+        {
+            Part parts[2] = {
+                {this, data, buf, half, !into_buf, depth - 1},
+                {this, data + half, buf + half, len - half, !into_buf,
+                 depth - 1}};
+
+            IndexBase::run_parallel(sort_part, &parts[0], &parts[1]);
+        }
+        else
+        {
+            sort(data, buf, half, !into_buf, 0);
+            sort(data + half, buf + half, len - half, !into_buf, 0);
+        }
+
+        if (into_buf)
+            merge(data, half, data + half, len - half, buf);
+        else
+            merge(buf, half, buf + half, len - half, data);
+    }
+
+    static void sort_part(void * data)
+    {
+        auto part = (Part *)data;
+        part->self->sort(part->data, part->buf, part->len, part->into_buf,
+                         part->depth);
+    }
+
+    F & m_compare;
+    const int m_depth;
+};
+
+} // namespace aud
+
 template<class T>
 class Index : private IndexBase
 {
@@ -188,10 +330,12 @@ public:
     }
 
     // compare(a, b) returns <0 if a<b, 0 if a=b, >0 if a>b
+    // the sort is stable; if <parallel> is true, large lists are sorted using
+    // several threads, so compare() must be safe to call concurrently
     template<class F>
-    void sort(F compare)
+    void sort(F compare, bool parallel = false)
     {
-        IndexBase::sort(WrapCompare<T, F>::run, sizeof(T), &compare);
+        aud::StableSort<T, F>(compare, parallel).sort(begin(), len());
     }
 
     // compare(key, val) returns <0 if key<val, 0 if key=val, >0 if key>val
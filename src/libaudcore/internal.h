@@ -23,6 +23,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include "audio.h"
+#include "equalizer.h"
 #include "index.h"
 #include "objects.h"
 
@@ -30,6 +32,7 @@ class InputPlugin;
 class Plugin;
 class PluginHandle;
 class VFSFile;
+class VFSImpl;
 class Tuple;
 
 typedef bool (*DirForeachFunc)(const char * path, const char * basename,
@@ -46,6 +49,7 @@ void art_cleanup();
 
 /* art-search.cc */
 String art_search(const char * filename);
+void art_search_cleanup();
 
 /* charset.cc */
 void chardet_init();
@@ -70,7 +74,79 @@ int effect_adjust_delay(int delay);
 bool effect_plugin_start(PluginHandle * plugin);
 void effect_plugin_stop(PluginHandle * plugin);
 
+/* equalizer-biquad.cc */
+/* Cascade of biquad sections (parametric equalizer).  The sections are run
+ * four at a time in a pipeline: while section 0 of a group filters the current
+ * sample, section 1 filters the previous output of section 0, and so on.  The
+ * four sections of a group are then independent of each other and are
+ * computed in parallel (SIMD) lanes.  The pipeline is filled and drained
+ * within each call to process(), so the output is not delayed. */
+class BiquadCascade
+{
+public:
+    void design(const Index<EqBand> & bands, double preamp, int rate);
+    int rate() const { return m_rate; }
+
+    void reset(int channels);
+
+    /* keeps the filter state of the sections common to both cascades */
+    void take_coefs(BiquadCascade && source);
+
+    void process(float * data, int samples);
+
+private:
+    static constexpr int lanes = 4;
+
+    struct Group
+    {
+        float b0[lanes], b1[lanes], b2[lanes], a1[lanes], a2[lanes];
+    };
+
+    struct State
+    {
+        float z1[lanes], z2[lanes];
+    };
+
+    Index<Group> m_groups;
+    Index<State> m_state; /* one per group and channel */
+    int m_channels = 0, m_rate = 0;
+    float m_gain = 1;
+};
+
 /* equalizer.cc */
+class EqFilter
+{
+public:
+    void set_format(int channels, int rate);
+    void set_bands(double preamp, const double * values); /* classic mode */
+    void set_bands_from_config();
+
+    /* Switches to parametric mode.  <cascade> should be designed for the
+     * current sample rate (see get_rate()), so that the coefficients can be
+     * computed without holding any lock; if the rate has since changed, the
+     * cascade is designed again here. */
+    int get_rate() const { return rate; }
+    void set_parametric(Index<EqBand> && bands, double preamp,
+                        BiquadCascade && cascade);
+
+    /* not thread-safe; each stream needs its own EqFilter */
+    void process(float * data, int samples);
+
+private:
+    int channels = 0, rate = 0;
+    int K = 0; /* Number of used EQ bands */
+
+    bool parametric = false;
+    Index<EqBand> param_bands;
+    double param_preamp = 0;
+    BiquadCascade cascade;
+
+    float a[AUD_EQ_NBANDS][2]; /* A weights */
+    float b[AUD_EQ_NBANDS][2]; /* B weights */
+    float wqv[AUD_MAX_CHANNELS][AUD_EQ_NBANDS][2]; /* Circular buffer for W data */
+    float gv[AUD_MAX_CHANNELS][AUD_EQ_NBANDS]; /* Gain factor for each channel and band */
+};
+
 void eq_init();
 void eq_cleanup();
 void eq_set_format(int new_channels, int new_rate);
@@ -98,6 +174,7 @@ void interface_run();
 /* do not call these; use aud_drct_play/stop() instead */
 void playback_play(int seek_time, bool pause);
 void playback_stop(bool exiting = false);
+void playback_continue();
 
 bool playback_check_serial(int serial);
 void playback_set_info(int entry, Tuple && tuple);
@@ -112,9 +189,31 @@ InputPlugin * load_input_plugin(PluginHandle * decoder,
 #define PROBE_FLAG_MIGHT_HAVE_SUBTUNES (1 << 1)
 int probe_by_filename(const char * filename);
 
+/* render.cc */
+void render_cleanup();
+
+/* called by the playback thread before decoding with <ip> (which stops any
+ * render using the same decoder) and with nullptr afterward */
+void render_set_playback_decoder(InputPlugin * ip);
+
+/* the input plugin API calls these when render_active() is true, that is, when
+ * called from a render thread rather than the playback thread */
+bool render_active();
+void render_open_audio(int format, int rate, int channels);
+void render_set_replay_gain(const ReplayGainInfo & gain);
+void render_write_audio(const void * data, int length);
+Tuple render_get_tuple();
+void render_set_tuple(Tuple && tuple);
+bool render_check_stop();
+int render_check_seek();
+
 /* runtime.cc */
 extern size_t misc_bytes_allocated;
 
+/* startup timing; stages may be recorded from any thread */
+int64_t startup_clock();
+void startup_stage(const char * name, int64_t begin);
+
 /* strpool.cc */
 void string_leak_check();
 
@@ -146,17 +245,23 @@ struct IntHashKey
     unsigned hash() const { return int32_hash(val); }
 };
 
+/* vfs.cc */
+VFSImpl * vfs_transport_open(const char * filename, const char * mode,
+                             String & error);
+
 /* vis-runner.cc */
 void vis_runner_start_stop(bool playing, bool paused);
 void vis_runner_pass_audio(int time, const Index<float> & data, int channels,
                            int rate);
 void vis_runner_flush();
 void vis_runner_enable(bool enable);
+void vis_runner_init();
+void vis_runner_cleanup();
 
 /* visualization.cc */
 void vis_activate(bool activate);
 void vis_send_clear();
-void vis_send_audio(const float * data, int channels);
+void vis_send_audio(const float * data, int channels, const float * freq);
 
 bool vis_plugin_start(PluginHandle * plugin);
 void vis_plugin_stop(PluginHandle * plugin);
@@ -0,0 +1,73 @@
+/*
+ * item-cache.cc
+ * Copyright 2016-2026 John Lindgren and Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "item-cache.h"
+
+ItemCacheRef::ItemCacheRef(ItemCache & cache, const char * filename)
+    : m_filename(filename), m_cache(cache)
+{
+    auto mh = m_cache.mutex.take();
+
+    m_node = m_cache.nodes.lookup(m_filename);
+    if (!m_node)
+        m_node = m_cache.nodes.add(m_filename, ItemCacheNode());
+
+    m_node->refcount++;
+}
+
+ItemCacheRef::~ItemCacheRef()
+{
+    auto mh = m_cache.mutex.take();
+
+    m_node->refcount--;
+    if (!m_node->refcount)
+        m_cache.nodes.remove(m_filename);
+}
+
+const Index<PlaylistAddItem> & ItemCacheRef::load()
+{
+    auto mh = m_cache.mutex.take();
+
+    switch (m_node->state)
+    {
+    case ItemCacheNode::NotLoaded:
+        // load the items in this thread
+        m_node->state = ItemCacheNode::Loading;
+        mh.unlock();
+        load_items(m_node->items);
+        mh.lock();
+
+        m_node->state = ItemCacheNode::Loaded;
+        m_cache.cond.notify_all();
+        break;
+
+    case ItemCacheNode::Loading:
+        // wait for the items to load in another thread
+        while (m_node->state != ItemCacheNode::Loaded)
+            m_cache.cond.wait(mh);
+
+        break;
+
+    case ItemCacheNode::Loaded:
+        // items already loaded
+        break;
+    }
+
+    return m_node->items;
+}
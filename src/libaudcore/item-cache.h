@@ -0,0 +1,73 @@
+/*
+ * item-cache.h
+ * Copyright 2016-2026 John Lindgren and Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef LIBAUDCORE_ITEM_CACHE_H
+#define LIBAUDCORE_ITEM_CACHE_H
+
+#include "index.h"
+#include "multihash.h"
+#include "threads.h"
+#include "tuple.h"
+
+struct ItemCacheNode
+{
+    enum State
+    {
+        NotLoaded,
+        Loading,
+        Loaded
+    };
+
+    Index<PlaylistAddItem> items;
+    State state = NotLoaded;
+    int refcount = 0;
+};
+
+/* one per kind of cached file */
+struct ItemCache
+{
+    SimpleHash<String, ItemCacheNode> nodes;
+    aud::mutex mutex;
+    aud::condvar cond;
+};
+
+/* Loads the playlist items of a file once and shares them between all the
+ * references to the file that exist at the same time.  The items are loaded
+ * by the first call to load(); concurrent calls from other threads wait for
+ * that one to finish. */
+class ItemCacheRef
+{
+public:
+    ItemCacheRef(ItemCache & cache, const char * filename);
+    virtual ~ItemCacheRef();
+
+    const Index<PlaylistAddItem> & load();
+
+protected:
+    /* called without any lock held, once for each file */
+    virtual void load_items(Index<PlaylistAddItem> & items) = 0;
+
+    const String m_filename;
+
+private:
+    ItemCache & m_cache;
+    ItemCacheNode * m_node;
+};
+
+#endif // LIBAUDCORE_ITEM_CACHE_H
@@ -0,0 +1,203 @@
+/*
+ * lockprof.cc
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "runtime.h"
+#include "threads.h"
+
+#ifdef AUD_PROFILE_LOCKS
+
+#include <inttypes.h>
+
+#include <chrono>
+
+#include "audstrings.h"
+#include "index.h"
+#include "internal.h"
+
+#define MAX_SITES 1024 /* must be a power of two */
+#define N_BUCKETS 8    /* < 1 us, < 10 us, ... < 1 s, >= 1 s */
+
+/* Statistics are updated with atomic operations, so that recording does not
+ * serialize the threads being measured.  A mutex is only taken to add a new
+ * site, which happens once per call site. */
+struct aud::LockSite
+{
+    const char * file; /* set last, when the site is ready */
+    int line;
+
+    int64_t acquired, contended;
+    int64_t wait_total, wait_max;
+    int64_t hold_total, hold_max;
+    int64_t wait_hist[N_BUCKETS];
+};
+
+using aud::LockSite;
+
+static LockSite sites[MAX_SITES];
+static LockSite overflow_site = {"(other)"};
+static std::mutex add_mutex;
+
+static void atomic_add(int64_t * val, int64_t add)
+{
+    __atomic_fetch_add(val, add, __ATOMIC_RELAXED);
+}
+
+static void atomic_max(int64_t * val, int64_t new_val)
+{
+    int64_t old = __atomic_load_n(val, __ATOMIC_RELAXED);
+    while (new_val > old &&
+           !__atomic_compare_exchange_n(val, &old, new_val, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+EXPORT LockSite * aud::lock_site(const char * file, int line)
+{
+    unsigned hash = ptr_hash(file) + int32_hash(line);
+
+    for (int i = 0; i < MAX_SITES; i++)
+    {
+        LockSite * site = &sites[(hash + i) & (MAX_SITES - 1)];
+        const char * site_file = __atomic_load_n(&site->file, __ATOMIC_ACQUIRE);
+
+        if (!site_file)
+        {
+            std::lock_guard<std::mutex> lock(add_mutex);
+
+            site_file = site->file;
+            if (!site_file)
+            {
+                site->line = line;
+                __atomic_store_n(&site->file, file, __ATOMIC_RELEASE);
+                return site;
+            }
+        }
+
+        if (site_file == file && site->line == line)
+            return site;
+    }
+
+    return &overflow_site;
+}
+
+EXPORT int64_t aud::lock_clock()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+EXPORT void aud::lock_acquired(LockSite * site, int64_t wait, bool contended)
+{
+    int bucket = 0;
+    for (int64_t limit = 1000; bucket < N_BUCKETS - 1 && wait >= limit;
+         limit *= 10)
+        bucket++;
+
+    atomic_add(&site->acquired, 1);
+    atomic_add(&site->wait_hist[bucket], 1);
+
+    if (contended)
+    {
+        atomic_add(&site->contended, 1);
+        atomic_add(&site->wait_total, wait);
+        atomic_max(&site->wait_max, wait);
+    }
+}
+
+EXPORT void aud::lock_released(LockSite * site, int64_t held)
+{
+    atomic_add(&site->hold_total, held);
+    atomic_max(&site->hold_max, held);
+}
+
+static int64_t load(const int64_t & val)
+{
+    return __atomic_load_n(&val, __ATOMIC_RELAXED);
+}
+
+EXPORT String aud_lock_profile_report(bool reset)
+{
+    Index<LockSite *> list;
+
+    for (LockSite & site : sites)
+    {
+        if (__atomic_load_n(&site.file, __ATOMIC_ACQUIRE) && load(site.acquired))
+            list.append(&site);
+    }
+
+    if (load(overflow_site.acquired))
+        list.append(&overflow_site);
+
+    list.sort([](LockSite * a, LockSite * b) {
+        int64_t wa = load(a->wait_total), wb = load(b->wait_total);
+        return (wa < wb) ? 1 : (wa > wb) ? -1 : 0;
+    });
+
+    StringBuf report =
+        str_printf("%-28s %10s %10s %10s %9s %10s %9s   wait histogram "
+                   "(<1us <10us <100us <1ms <10ms <100ms <1s >=1s)\n",
+                   "site", "acquired", "contended", "wait ms", "wait max",
+                   "hold ms", "hold max");
+
+    for (LockSite * site : list)
+    {
+        const char * base = last_path_element(site->file);
+        StringBuf name = str_printf("%s:%d", base ? base : site->file,
+                                    site->line);
+
+        str_append_printf(report, "%-28s %10" PRId64 " %10" PRId64
+                          " %10.1f %7.1fus %10.1f %7.1fus  ",
+                          (const char *)name, load(site->acquired),
+                          load(site->contended),
+                          load(site->wait_total) / 1e6,
+                          load(site->wait_max) / 1e3,
+                          load(site->hold_total) / 1e6,
+                          load(site->hold_max) / 1e3);
+
+        for (int i = 0; i < N_BUCKETS; i++)
+            str_append_printf(report, " %" PRId64, load(site->wait_hist[i]));
+
+        str_append_printf(report, "\n");
+    }
+
+    if (reset)
+    {
+        /* updates made concurrently by other threads may be lost */
+        for (LockSite * site : list)
+        {
+            int64_t * stats[] = {&site->acquired,   &site->contended,
+                                 &site->wait_total, &site->wait_max,
+                                 &site->hold_total, &site->hold_max};
+
+            for (int64_t * stat : stats)
+                __atomic_store_n(stat, 0, __ATOMIC_RELAXED);
+            for (int64_t & count : site->wait_hist)
+                __atomic_store_n(&count, 0, __ATOMIC_RELAXED);
+        }
+    }
+
+    return String(report);
+}
+
+#else // ! AUD_PROFILE_LOCKS
+
+EXPORT String aud_lock_profile_report(bool) { return String(); }
+
+#endif // ! AUD_PROFILE_LOCKS
@@ -219,8 +219,10 @@ public:
     // appended uninitialized bytes or truncating.  The resized string will be
     // null-terminated unless <len> is -1.  A length of -1 means to make the
     // string as large as possible.  This can be useful when the required length
-    // is not known in advance.  However, it will be impossible to create any
-    // further StringBufs until resize() is called again.
+    // is not known in advance.  However, any further StringBufs will be
+    // allocated from the heap (which is slower) until resize() is called
+    // again.  Strings too large for the per-thread stack are also moved to
+    // the heap rather than failing.
     void resize(int len);
 
     // Inserts the substring <s> at the given position, or appends it if <pos>
@@ -24,6 +24,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <glib.h>
+
 #include "equalizer.h"
 #include "hook.h"
 #include "i18n.h"
@@ -145,22 +147,256 @@ static OutputState state;
 static OutputPlugin * cop; /* current (primary) output plugin */
 static OutputPlugin * sop; /* secondary output plugin */
 
-static OutputStream record_stream;
+/* Converts audio to the channel count and sample rate of an output device that
+ * was kept open for a stream in a different format ("output_keep_open").
+ * Channels are remixed according to the standard layouts (see build_matrix())
+ * and the rate is converted by linear interpolation, which is cheap but not of
+ * the quality of the resample plugin. */
+class FormatConverter
+{
+public:
+    static bool can_remix(int in_channels, int out_channels);
+
+    bool active() const { return m_active; }
+
+    void setup(int in_channels, int in_rate, int out_channels, int out_rate);
+    void reset();
+
+    Index<float> & process(Index<float> & data);
+
+private:
+    bool m_active = false;
+    int m_in_channels = 0, m_in_rate = 0;
+    int m_out_channels = 0, m_out_rate = 0;
 
-static int seek_time;
-static String in_filename;
-static Tuple in_tuple;
-static int in_format, in_channels, in_rate;
-static int effect_channels, effect_rate;
-static int sec_channels, sec_rate;
-static int out_format, out_channels, out_rate;
-static int out_bytes_per_sec, out_bytes_held;
-static int64_t in_frames, out_bytes_written;
-static ReplayGainInfo gain_info;
-static bool gain_info_valid;
+    /* position of the next output frame, in input frames from the start of
+     * the next block; -1 refers to the last frame of the previous block */
+    double m_pos = 0;
+    float m_last[AUD_MAX_CHANNELS] = {};
 
-static Index<float> buffer1;
-static Index<char> buffer2;
+    /* gain of each input channel (column) in each output channel (row) */
+    float m_matrix[AUD_MAX_CHANNELS][AUD_MAX_CHANNELS] = {};
+
+    Index<float> m_mixed, m_resampled;
+
+    static bool build_matrix(int in_channels, int out_channels,
+                             float (*matrix)[AUD_MAX_CHANNELS]);
+
+    void remix(const Index<float> & data);
+    void resample(const Index<float> & data);
+};
+
+/* The channel orders are those used by the decoders (as in WAVE files):
+ *   3.0: front left, front right, center
+ *   4.0: front left, front right, rear left, rear right
+ *   5.0: front left, front right, center, rear left, rear right
+ *   5.1: front left, front right, center, LFE, rear left, rear right
+ * Mono goes to the front channels and stereo to the front of a surround
+ * layout.  Surround layouts are mixed down to stereo with the center and
+ * rear channels at -3 dB and the LFE channel at -6 dB, and further to mono
+ * by averaging.  Any other conversion is refused, and the output device is
+ * reopened instead. */
+bool FormatConverter::build_matrix(int in_channels, int out_channels,
+                                   float (*matrix)[AUD_MAX_CHANNELS])
+{
+    const float center = M_SQRT1_2, rear = M_SQRT1_2, lfe = 0.5f;
+    auto m = matrix;
+
+    // front left and right (or mono) pass through unchanged
+    for (int o = 0; o < AUD_MAX_CHANNELS; o++)
+    {
+        for (int i = 0; i < AUD_MAX_CHANNELS; i++)
+            m[o][i] = (o == i && o < aud::min(in_channels, 2)) ? 1 : 0;
+    }
+
+    if (in_channels == out_channels)
+    {
+        for (int c = 0; c < in_channels; c++)
+            m[c][c] = 1;
+
+        return true;
+    }
+
+    if (in_channels == 1)
+    {
+        for (int c = 0; c < aud::min(out_channels, 2); c++)
+            m[c][0] = 1;
+
+        return true;
+    }
+
+    if (in_channels == 2 && out_channels > 2)
+        return true;
+
+    if (out_channels > 2)
+        return false;
+
+    switch (in_channels)
+    {
+    case 2:
+        break;
+    case 3:
+        m[0][2] = m[1][2] = center;
+        break;
+    case 4:
+        m[0][2] = m[1][3] = rear;
+        break;
+    case 5:
+        m[0][2] = m[1][2] = center;
+        m[0][3] = m[1][4] = rear;
+        break;
+    case 6:
+        m[0][2] = m[1][2] = center;
+        m[0][3] = m[1][3] = lfe;
+        m[0][4] = m[1][5] = rear;
+        break;
+    default:
+        return false;
+    }
+
+    if (out_channels == 1)
+    {
+        for (int i = 0; i < in_channels; i++)
+            m[0][i] = (m[0][i] + m[1][i]) / 2;
+    }
+
+    return true;
+}
+
+bool FormatConverter::can_remix(int in_channels, int out_channels)
+{
+    float matrix[AUD_MAX_CHANNELS][AUD_MAX_CHANNELS];
+    return build_matrix(in_channels, out_channels, matrix);
+}
+
+void FormatConverter::setup(int in_channels, int in_rate, int out_channels,
+                            int out_rate)
+{
+    m_active = (in_channels != out_channels || in_rate != out_rate);
+    m_in_channels = in_channels;
+    m_in_rate = in_rate;
+    m_out_channels = out_channels;
+    m_out_rate = out_rate;
+
+    build_matrix(in_channels, out_channels, m_matrix);
+    reset();
+}
+
+void FormatConverter::reset()
+{
+    m_pos = 0;
+    memset(m_last, 0, sizeof m_last);
+}
+
+void FormatConverter::remix(const Index<float> & data)
+{
+    int frames = data.len() / m_in_channels;
+
+    m_mixed.resize(frames * m_out_channels);
+    float * out = m_mixed.begin();
+    const float * in = data.begin();
+
+    for (int f = 0; f < frames; f++)
+    {
+        for (int o = 0; o < m_out_channels; o++)
+        {
+            float sum = 0;
+            for (int i = 0; i < m_in_channels; i++)
+                sum += in[i] * m_matrix[o][i];
+
+            out[o] = sum;
+        }
+
+        in += m_in_channels;
+        out += m_out_channels;
+    }
+}
+
+void FormatConverter::resample(const Index<float> & data)
+{
+    int channels = m_out_channels;
+    int frames = data.len() / channels;
+    double step = (double)m_in_rate / m_out_rate;
+
+    m_resampled.resize(0);
+    if (!frames)
+        return;
+
+    m_resampled.resize((int)((frames - m_pos) / step + 2) * channels);
+    float * out = m_resampled.begin();
+    const float * in = data.begin();
+
+    while (m_pos < frames - 1)
+    {
+        int i = floor(m_pos);
+        float t = m_pos - i;
+        const float * a = (i < 0) ? m_last : in + i * channels;
+        const float * b = in + (i + 1) * channels;
+
+        for (int c = 0; c < channels; c++)
+            *out++ = a[c] + (b[c] - a[c]) * t;
+
+        m_pos += step;
+    }
+
+    memcpy(m_last, in + (frames - 1) * channels, sizeof(float) * channels);
+    m_pos -= frames;
+
+    m_resampled.remove(out - m_resampled.begin(), -1);
+}
+
+Index<float> & FormatConverter::process(Index<float> & data)
+{
+    Index<float> * result = &data;
+
+    if (m_in_channels != m_out_channels)
+    {
+        remix(*result);
+        result = &m_mixed;
+    }
+
+    if (m_in_rate != m_out_rate)
+    {
+        resample(*result);
+        result = &m_resampled;
+    }
+
+    return *result;
+}
+
+/* Data describing the stream passing through the output pipeline, protected
+ * by the minor mutex.  The output plugins themselves are process-wide, but
+ * everything specific to one stream lives here rather than in separate
+ * globals. */
+struct OutputPipeline
+{
+    OutputStream record_stream;
+
+    int seek_time;
+    String in_filename;
+    Tuple in_tuple;
+    int in_format, in_channels, in_rate;
+    int effect_channels, effect_rate;
+    int sec_channels, sec_rate;
+    int out_format, out_channels, out_rate;
+    int out_bytes_per_sec, out_bytes_held;
+    int64_t in_frames, out_bytes_written;
+    ReplayGainInfo gain_info;
+    bool gain_info_valid;
+
+    Index<float> buffer1;
+    Index<char> buffer2;
+
+    /* used when the output is kept open for a stream in a different format */
+    FormatConverter converter;
+
+    /* time taken to reopen the output between streams */
+    int64_t close_time;
+    int reopen_count;
+    int64_t reopen_total;
+};
+
+static OutputPipeline pl;
 
 static inline int get_format(bool & automatic)
 {
@@ -187,11 +423,11 @@ static void setup_effects(SafeLock &)
 {
     assert(state.input());
 
-    effect_channels = in_channels;
-    effect_rate = in_rate;
+    pl.effect_channels = pl.in_channels;
+    pl.effect_rate = pl.in_rate;
 
-    effect_start(effect_channels, effect_rate);
-    eq_set_format(effect_channels, effect_rate);
+    effect_start(pl.effect_channels, pl.effect_rate);
+    eq_set_format(pl.effect_channels, pl.effect_rate);
 }
 
 static void cleanup_output(UnsafeLock & lock)
@@ -201,7 +437,7 @@ static void cleanup_output(UnsafeLock & lock)
 
     // avoid locking up if the input thread reaches close_audio() while
     // paused (unlikely but possible with perfect timing)
-    if (out_bytes_written && !state.paused())
+    if (pl.out_bytes_written && !state.paused())
     {
         lock.minor.unlock();
         cop->drain();
@@ -210,9 +446,10 @@ static void cleanup_output(UnsafeLock & lock)
 
     state.set_output(lock, false);
 
-    buffer1.clear();
-    buffer2.clear();
+    pl.buffer1.clear();
+    pl.buffer2.clear();
 
+    pl.close_time = g_get_monotonic_time();
     cop->close_audio();
     vis_runner_start_stop(false, false);
 }
@@ -258,23 +495,39 @@ static void setup_output(UnsafeLock & lock, bool new_input, bool pause)
     bool automatic;
     int format = get_format(automatic);
 
-    if (state.output() && effect_channels == out_channels &&
-        effect_rate == out_rate && !(new_input && cop->force_reopen))
+    bool same_format = (pl.effect_channels == pl.out_channels &&
+                        pl.effect_rate == pl.out_rate);
+    bool keep_open =
+        aud_get_bool("output_keep_open") &&
+        FormatConverter::can_remix(pl.effect_channels, pl.out_channels);
+
+    if (state.output() && (same_format || keep_open) &&
+        !(new_input && cop->force_reopen))
     {
-        AUDINFO("Reuse output, %d channels, %d Hz.\n", effect_channels,
-                effect_rate);
+        if (same_format)
+            AUDINFO("Reuse output, %d channels, %d Hz.\n", pl.effect_channels,
+                    pl.effect_rate);
+        else
+            AUDINFO("Keep output open, converting %d channels, %d Hz to %d "
+                    "channels, %d Hz.\n",
+                    pl.effect_channels, pl.effect_rate, pl.out_channels,
+                    pl.out_rate);
+
+        pl.converter.setup(pl.effect_channels, pl.effect_rate, pl.out_channels,
+                           pl.out_rate);
         apply_pause(lock, pause);
         return;
     }
 
     AUDINFO("Setup output, format %d, %d channels, %d Hz.\n", format,
-            effect_channels, effect_rate);
+            pl.effect_channels, pl.effect_rate);
 
+    bool reopen = state.output();
     cleanup_output(lock);
 
     String error;
-    while (!open_audio_with_info(cop, in_filename, in_tuple, format,
-                                 effect_rate, effect_channels, error))
+    while (!open_audio_with_info(cop, pl.in_filename, pl.in_tuple, format,
+                                 pl.effect_rate, pl.effect_channels, error))
     {
         if (automatic && format == FMT_FLOAT)
             format = FMT_S32_NE;
@@ -295,13 +548,28 @@ static void setup_output(UnsafeLock & lock, bool new_input, bool pause)
 
     state.set_output(lock, true);
 
-    out_format = format;
-    out_channels = effect_channels;
-    out_rate = effect_rate;
+    if (reopen)
+    {
+        int64_t elapsed = g_get_monotonic_time() - pl.close_time;
+
+        pl.reopen_count++;
+        pl.reopen_total += elapsed;
+
+        AUDINFO("Output reopened in %.1f ms (%d reopens, %.1f ms average).\n",
+                elapsed / 1000.0, pl.reopen_count,
+                pl.reopen_total / 1000.0 / pl.reopen_count);
+    }
+
+    pl.converter.setup(pl.effect_channels, pl.effect_rate, pl.effect_channels,
+                       pl.effect_rate);
 
-    out_bytes_per_sec = FMT_SIZEOF(format) * out_channels * out_rate;
-    out_bytes_held = 0;
-    out_bytes_written = 0;
+    pl.out_format = format;
+    pl.out_channels = pl.effect_channels;
+    pl.out_rate = pl.effect_rate;
+
+    pl.out_bytes_per_sec = FMT_SIZEOF(format) * pl.out_channels * pl.out_rate;
+    pl.out_bytes_held = 0;
+    pl.out_bytes_written = 0;
 
     apply_pause(lock, pause, true);
 }
@@ -314,28 +582,28 @@ static void setup_secondary(SafeLock & lock, bool new_input)
         return;
 
     int rate, channels;
-    record_stream = (OutputStream)aud_get_int("record_stream");
+    pl.record_stream = (OutputStream)aud_get_int("record_stream");
 
-    if (record_stream < OutputStream::AfterEffects)
+    if (pl.record_stream < OutputStream::AfterEffects)
     {
-        rate = in_rate;
-        channels = in_channels;
+        rate = pl.in_rate;
+        channels = pl.in_channels;
     }
     else
     {
-        rate = effect_rate;
-        channels = effect_channels;
+        rate = pl.effect_rate;
+        channels = pl.effect_channels;
     }
 
-    if (state.secondary() && channels == sec_channels && rate == sec_rate &&
-        !(new_input && sop->force_reopen))
+    if (state.secondary() && channels == pl.sec_channels &&
+        rate == pl.sec_rate && !(new_input && sop->force_reopen))
         return;
 
     cleanup_secondary(lock);
 
     String error;
-    if (!open_audio_with_info(sop, in_filename, in_tuple, FMT_FLOAT, rate,
-                              channels, error))
+    if (!open_audio_with_info(sop, pl.in_filename, pl.in_tuple, FMT_FLOAT,
+                              rate, channels, error))
     {
         aud_ui_show_error(error ? (const char *)error
                                 : _("Error recording output stream"));
@@ -344,29 +612,32 @@ static void setup_secondary(SafeLock & lock, bool new_input)
 
     state.set_secondary(lock, true);
 
-    sec_channels = channels;
-    sec_rate = rate;
+    pl.sec_channels = channels;
+    pl.sec_rate = rate;
 }
 
 static void flush_output(SafeLock &)
 {
     assert(state.output());
 
-    out_bytes_held = 0;
-    out_bytes_written = 0;
+    pl.out_bytes_held = 0;
+    pl.out_bytes_written = 0;
+    pl.converter.reset();
 
     cop->flush();
     vis_runner_flush();
 }
 
-static void apply_replay_gain(SafeLock &, Index<float> & data)
+/* returns the amplification factor to be applied according to the user's
+ * replay gain settings; <info> may be null if the song has no gain info */
+float output_replay_gain_factor(const ReplayGainInfo * info)
 {
     if (!aud_get_bool("enable_replay_gain"))
-        return;
+        return 1;
 
     float factor = powf(10, aud_get_double("replay_gain_preamp") / 20);
 
-    if (gain_info_valid)
+    if (info)
     {
         float peak;
 
@@ -375,13 +646,13 @@ static void apply_replay_gain(SafeLock &, Index<float> & data)
             (mode == ReplayGainMode::Automatic &&
              (!aud_get_bool("shuffle") || aud_get_bool("album_shuffle"))))
         {
-            factor *= powf(10, gain_info.album_gain / 20);
-            peak = gain_info.album_peak;
+            factor *= powf(10, info->album_gain / 20);
+            peak = info->album_peak;
         }
         else
         {
-            factor *= powf(10, gain_info.track_gain / 20);
-            peak = gain_info.track_peak;
+            factor *= powf(10, info->track_gain / 20);
+            peak = info->track_peak;
         }
 
         if (aud_get_bool("enable_clipping_prevention") && peak * factor > 1)
@@ -390,6 +661,14 @@ static void apply_replay_gain(SafeLock &, Index<float> & data)
     else
         factor *= powf(10, aud_get_double("default_gain") / 20);
 
+    return factor;
+}
+
+static void apply_replay_gain(SafeLock &, Index<float> & data)
+{
+    float factor = output_replay_gain_factor(
+        pl.gain_info_valid ? &pl.gain_info : nullptr);
+
     if (factor < 0.99 || factor > 1.01)
         audio_amplify(data.begin(), 1, data.len(), &factor);
 }
@@ -412,40 +691,44 @@ static void write_output(UnsafeLock & lock, Index<float> & data)
     if (!data.len())
         return;
 
-    if (state.secondary() && record_stream == OutputStream::AfterEffects)
+    if (state.secondary() && pl.record_stream == OutputStream::AfterEffects)
         write_secondary(lock, data);
 
     int out_time =
-        aud::rescale<int64_t>(out_bytes_written, out_bytes_per_sec, 1000);
-    vis_runner_pass_audio(out_time, data, out_channels, out_rate);
+        aud::rescale<int64_t>(pl.out_bytes_written, pl.out_bytes_per_sec, 1000);
+    vis_runner_pass_audio(out_time, data, pl.effect_channels, pl.effect_rate);
 
     eq_filter(data.begin(), data.len());
 
-    if (state.secondary() && record_stream == OutputStream::AfterEqualizer)
+    if (state.secondary() && pl.record_stream == OutputStream::AfterEqualizer)
         write_secondary(lock, data);
 
     if (aud_get_bool("software_volume_control"))
     {
         StereoVolume v = {aud_get_int("sw_volume_left"),
                           aud_get_int("sw_volume_right")};
-        audio_amplify(data.begin(), out_channels, data.len() / out_channels, v);
+        audio_amplify(data.begin(), pl.effect_channels,
+                      data.len() / pl.effect_channels, v);
     }
 
     if (aud_get_bool("soft_clipping"))
         audio_soft_clip(data.begin(), data.len());
 
-    const void * out_data = data.begin();
+    Index<float> & out = pl.converter.active() ? pl.converter.process(data)
+                                               : data;
+    const void * out_data = out.begin();
 
-    if (out_format != FMT_FLOAT)
+    if (pl.out_format != FMT_FLOAT)
     {
-        buffer2.resize(FMT_SIZEOF(out_format) * data.len());
-        audio_to_int(data.begin(), buffer2.begin(), out_format, data.len());
-        out_data = buffer2.begin();
+        pl.buffer2.resize(FMT_SIZEOF(pl.out_format) * out.len());
+        audio_to_int(out.begin(), pl.buffer2.begin(), pl.out_format,
+                     out.len());
+        out_data = pl.buffer2.begin();
     }
 
-    out_bytes_held = FMT_SIZEOF(out_format) * data.len();
+    pl.out_bytes_held = FMT_SIZEOF(pl.out_format) * out.len();
 
-    while (out_bytes_held && !state.resetting())
+    while (pl.out_bytes_held && !state.resetting())
     {
         if (state.paused())
         {
@@ -458,13 +741,13 @@ static void write_output(UnsafeLock & lock, Index<float> & data)
             continue;
         }
 
-        int written = cop->write_audio(out_data, out_bytes_held);
+        int written = cop->write_audio(out_data, pl.out_bytes_held);
 
         out_data = (const char *)out_data + written;
-        out_bytes_held -= written;
-        out_bytes_written += written;
+        pl.out_bytes_held -= written;
+        pl.out_bytes_written += written;
 
-        if (!out_bytes_held)
+        if (!pl.out_bytes_held)
             break;
 
         lock.minor.unlock();
@@ -474,19 +757,20 @@ static void write_output(UnsafeLock & lock, Index<float> & data)
 }
 
 static bool process_audio(UnsafeLock & lock, const void * data, int size,
-                          int stop_time)
+                          int stop_time, int * written)
 {
     assert(state.input() && state.output());
 
-    int samples = size / FMT_SIZEOF(in_format);
+    int samples = size / FMT_SIZEOF(pl.in_format);
     bool stopped = false;
 
     if (stop_time != -1)
     {
         int64_t frames_left =
-            aud::rescale<int64_t>(stop_time - seek_time, 1000, in_rate) -
-            in_frames;
-        int64_t samples_left = in_channels * aud::max((int64_t)0, frames_left);
+            aud::rescale<int64_t>(stop_time - pl.seek_time, 1000, pl.in_rate) -
+            pl.in_frames;
+        int64_t samples_left =
+            pl.in_channels * aud::max((int64_t)0, frames_left);
 
         if (samples >= samples_left)
         {
@@ -495,24 +779,27 @@ static bool process_audio(UnsafeLock & lock, const void * data, int size,
         }
     }
 
-    in_frames += samples / in_channels;
+    pl.in_frames += samples / pl.in_channels;
+
+    if (written)
+        *written = FMT_SIZEOF(pl.in_format) * samples;
 
-    buffer1.resize(samples);
+    pl.buffer1.resize(samples);
 
-    if (in_format == FMT_FLOAT)
-        memcpy(buffer1.begin(), data, sizeof(float) * samples);
+    if (pl.in_format == FMT_FLOAT)
+        memcpy(pl.buffer1.begin(), data, sizeof(float) * samples);
     else
-        audio_from_int(data, in_format, buffer1.begin(), samples);
+        audio_from_int(data, pl.in_format, pl.buffer1.begin(), samples);
 
-    if (state.secondary() && record_stream == OutputStream::AsDecoded)
-        write_secondary(lock, buffer1);
+    if (state.secondary() && pl.record_stream == OutputStream::AsDecoded)
+        write_secondary(lock, pl.buffer1);
 
-    apply_replay_gain(lock, buffer1);
+    apply_replay_gain(lock, pl.buffer1);
 
-    if (state.secondary() && record_stream == OutputStream::AfterReplayGain)
-        write_secondary(lock, buffer1);
+    if (state.secondary() && pl.record_stream == OutputStream::AfterReplayGain)
+        write_secondary(lock, pl.buffer1);
 
-    write_output(lock, effect_process(buffer1));
+    write_output(lock, effect_process(pl.buffer1));
 
     return !stopped;
 }
@@ -521,8 +808,8 @@ static void finish_effects(UnsafeLock & lock, bool end_of_playlist)
 {
     assert(state.output());
 
-    buffer1.resize(0);
-    write_output(lock, effect_finish(buffer1, end_of_playlist));
+    pl.buffer1.resize(0);
+    write_output(lock, effect_finish(pl.buffer1, end_of_playlist));
 }
 
 bool output_open_audio(const String & filename, const Tuple & tuple, int format,
@@ -537,15 +824,15 @@ bool output_open_audio(const String & filename, const Tuple & tuple, int format,
     state.set_input(lock, true);
     state.set_flushed(lock, false);
 
-    seek_time = start_time;
-    gain_info_valid = false;
+    pl.seek_time = start_time;
+    pl.gain_info_valid = false;
 
-    in_filename = filename;
-    in_tuple = tuple.ref();
-    in_format = format;
-    in_channels = channels;
-    in_rate = rate;
-    in_frames = 0;
+    pl.in_filename = filename;
+    pl.in_tuple = tuple.ref();
+    pl.in_format = format;
+    pl.in_channels = channels;
+    pl.in_rate = rate;
+    pl.in_frames = 0;
 
     setup_effects(lock);
     setup_output(lock, true, pause);
@@ -561,7 +848,7 @@ void output_set_tuple(const Tuple & tuple)
     auto lock = state.lock_safe();
 
     if (state.input())
-        in_tuple = tuple.ref();
+        pl.in_tuple = tuple.ref();
 }
 
 void output_set_replay_gain(const ReplayGainInfo & info)
@@ -570,8 +857,8 @@ void output_set_replay_gain(const ReplayGainInfo & info)
 
     if (state.input())
     {
-        gain_info = info;
-        gain_info_valid = true;
+        pl.gain_info = info;
+        pl.gain_info_valid = true;
 
         AUDINFO("Replay Gain info:\n");
         AUDINFO(" album gain: %f dB\n", info.album_gain);
@@ -581,9 +868,14 @@ void output_set_replay_gain(const ReplayGainInfo & info)
     }
 }
 
-/* returns false if stop_time is reached */
-bool output_write_audio(const void * data, int size, int stop_time)
+/* returns false if stop_time is reached; if <written> is given, it is set to
+ * the number of bytes actually consumed */
+bool output_write_audio(const void * data, int size, int stop_time,
+                        int * written)
 {
+    if (written)
+        *written = 0;
+
     while (1)
     {
         auto lock = state.lock_unsafe();
@@ -591,13 +883,27 @@ bool output_write_audio(const void * data, int size, int stop_time)
             return false;
 
         if (state.output() && !state.resetting())
-            return process_audio(lock, data, size, stop_time);
+            return process_audio(lock, data, size, stop_time, written);
 
         lock.major.unlock();
         state.await_change(lock);
     }
 }
 
+/* continues the same stream into a new segment (for example, the next track of
+ * a cuesheet) beginning at <time>, relative to the start of the old segment;
+ * audio already written is still played, so the effects are not finished */
+void output_next_segment(const Tuple & tuple, int time)
+{
+    auto lock = state.lock_safe();
+
+    if (state.input())
+    {
+        pl.seek_time -= time;
+        pl.in_tuple = tuple.ref();
+    }
+}
+
 void output_flush(int time, bool force)
 {
     auto lock = state.lock_safe();
@@ -614,8 +920,8 @@ void output_flush(int time, bool force)
     if (state.input())
     {
         state.set_flushed(lock, true);
-        seek_time = time;
-        in_frames = 0;
+        pl.seek_time = time;
+        pl.in_frames = 0;
     }
 }
 
@@ -645,13 +951,14 @@ int output_get_time()
         if (state.output())
         {
             delay = cop->get_delay();
-            delay +=
-                aud::rescale<int64_t>(out_bytes_held, out_bytes_per_sec, 1000);
+            delay += aud::rescale<int64_t>(pl.out_bytes_held,
+                                           pl.out_bytes_per_sec, 1000);
         }
 
         delay = effect_adjust_delay(delay);
-        time = aud::rescale<int64_t>(in_frames, in_rate, 1000);
-        time = seek_time + aud::max(time - delay, 0);
+        time = aud::rescale<int64_t>(pl.in_frames, pl.in_rate, 1000);
+        /* seek_time is negative until a new segment is heard */
+        time = aud::max(pl.seek_time + aud::max(time - delay, 0), 0);
     }
 
     return time;
@@ -664,8 +971,8 @@ int output_get_raw_time()
 
     if (state.output())
     {
-        time =
-            aud::rescale<int64_t>(out_bytes_written, out_bytes_per_sec, 1000);
+        time = aud::rescale<int64_t>(pl.out_bytes_written,
+                                     pl.out_bytes_per_sec, 1000);
         time = aud::max(time - cop->get_delay(), 0);
     }
 
@@ -679,8 +986,8 @@ void output_close_audio()
     if (state.input())
     {
         state.set_input(lock, false);
-        in_filename = String();
-        in_tuple = Tuple();
+        pl.in_filename = String();
+        pl.in_tuple = Tuple();
 
         if (state.output())
             finish_effects(lock, false); /* first time for end of song */
@@ -781,6 +1088,8 @@ EXPORT void aud_drct_set_volume(StereoVolume volume)
     }
     else if (cop)
         cop->set_volume(volume);
+
+    event_queue("volume change", nullptr);
 }
 
 PluginHandle * output_plugin_get_current()
@@ -33,7 +33,10 @@ bool output_open_audio(const String & filename, const Tuple & tuple, int format,
                        int rate, int channels, int start_time, bool pause);
 void output_set_tuple(const Tuple & tuple);
 void output_set_replay_gain(const ReplayGainInfo & info);
-bool output_write_audio(const void * data, int size, int stop_time);
+float output_replay_gain_factor(const ReplayGainInfo * info);
+bool output_write_audio(const void * data, int size, int stop_time,
+                        int * written = nullptr);
+void output_next_segment(const Tuple & tuple, int time);
 void output_flush(int time, bool force = false);
 void output_resume();
 void output_pause(bool pause);
@@ -101,9 +101,10 @@ static PlaybackState pb_state;
 static PlaybackControl pb_control;
 static PlaybackInfo pb_info;
 
-static QueuedFunc end_queue;
+static QueuedFunc end_queue, segment_queue;
 static bool song_finished = false;
 static int failed_entries = 0;
+static int segments_pending = 0;
 
 // check that the playback thread is not lagging
 static bool in_sync(aud::mutex::holder &)
@@ -169,7 +170,9 @@ static void playback_cleanup(aud::mutex::holder &)
 
     // miscellaneous cleanup
     end_queue.stop();
+    segment_queue.stop();
     song_finished = false;
+    segments_pending = 0;
 
     event_queue_cancel("playback ready");
     event_queue_cancel("playback pause");
@@ -255,6 +258,50 @@ static void end_cb(void *)
     }
 }
 
+// called from top-level event loop after the playback thread has moved on to
+// the next segment of the same file (see next_segment())
+static void next_segment_cb(void *)
+{
+    int segments;
+
+    {
+        auto mh = mutex.take();
+        segments = segments_pending;
+        segments_pending = 0;
+    }
+
+    for (; segments > 0; segments--)
+    {
+        hook_call("playback end", nullptr);
+
+        if (!aud_drct_get_playing())
+            return;
+
+        // the playlist normally follows along without restarting playback;
+        // if it was changed in the meantime, start the next song from scratch
+        if (!playback_entry_continue())
+        {
+            PlaylistEx playlist = Playlist::playing_playlist();
+            if (!playlist.next_song(aud_get_bool("repeat")))
+            {
+                playlist.set_position(-1);
+                hook_call("playlist end reached", nullptr);
+            }
+
+            return;
+        }
+    }
+}
+
+// main thread: called by the playlist after it has moved to the segment that
+// the playback thread is already playing
+void playback_continue()
+{
+    auto mh = mutex.take();
+    if (is_ready(mh))
+        event_queue("playback ready", nullptr);
+}
+
 // helper, can be called from either main or playback thread
 static void request_seek(aud::mutex::holder & mh, int time)
 {
@@ -270,6 +317,18 @@ static void request_seek(aud::mutex::holder & mh, int time)
     }
 }
 
+// playback thread helper
+static void read_segment_info(aud::mutex::holder &)
+{
+    // get various other bits of info from the tuple
+    pb_info.length = pb_info.tuple.get_int(Tuple::Length);
+    pb_info.time_offset = aud::max(0, pb_info.tuple.get_int(Tuple::StartTime));
+    pb_info.stop_time = aud::max(-1, pb_info.tuple.get_int(Tuple::EndTime) -
+                                         pb_info.time_offset);
+    pb_info.gain = pb_info.tuple.get_replay_gain();
+    pb_info.gain_valid = pb_info.tuple.has_replay_gain();
+}
+
 // playback thread helper
 static bool setup_playback(const DecodeInfo & dec)
 {
@@ -291,13 +350,7 @@ static bool setup_playback(const DecodeInfo & dec)
         return false;
     }
 
-    // get various other bits of info from the tuple
-    pb_info.length = pb_info.tuple.get_int(Tuple::Length);
-    pb_info.time_offset = aud::max(0, pb_info.tuple.get_int(Tuple::StartTime));
-    pb_info.stop_time = aud::max(-1, pb_info.tuple.get_int(Tuple::EndTime) -
-                                         pb_info.time_offset);
-    pb_info.gain = pb_info.tuple.get_replay_gain();
-    pb_info.gain_valid = pb_info.tuple.has_replay_gain();
+    read_segment_info(mh);
 
     // force initial seek if we are playing a segmented track
     if (pb_info.time_offset > 0 && pb_control.seek < 0)
@@ -333,6 +386,45 @@ static bool check_playback_repeat()
     return false;
 }
 
+// playback thread helper: at the end of a segmented track, continues decoding
+// into the next playlist entry if it is the following segment of the same file
+// (as with consecutive cuesheet tracks), without reopening the file or seeking
+static bool next_segment(aud::mutex::holder & mh)
+{
+    if (pb_info.stop_time < 0)
+        return false;
+
+    int serial = pb_state.playback_serial;
+
+    // due to mutex ordering, we cannot call into the playlist while locked
+    mh.unlock();
+    Tuple tuple = playback_entry_next_segment(serial);
+    mh.lock();
+
+    if (!tuple.valid() || !in_sync(mh) || pb_control.seek >= 0)
+        return false;
+
+    int boundary = pb_info.stop_time;
+    bool gain_valid = pb_info.gain_valid;
+
+    pb_info.tuple = std::move(tuple);
+    read_segment_info(mh);
+
+    output_next_segment(pb_info.tuple, boundary);
+
+    // otherwise keep any gain set by the input plugin
+    if (pb_info.gain_valid)
+        output_set_replay_gain(pb_info.gain);
+    else
+        pb_info.gain_valid = gain_valid;
+
+    // the main thread then moves the playlist to the new entry
+    segments_pending++;
+    segment_queue.queue(next_segment_cb, nullptr);
+
+    return true;
+}
+
 // playback thread helper
 static void run_playback()
 {
@@ -342,6 +434,9 @@ static void run_playback()
     if (!setup_playback(dec))
         return;
 
+    // input plugins are not re-entrant; keep render jobs off the decoder
+    render_set_playback_decoder(dec.ip);
+
     while (1)
     {
         // hand off control to input plugin
@@ -365,6 +460,8 @@ static void run_playback()
             break;
         }
     }
+
+    render_set_playback_decoder(nullptr);
 }
 
 // playback thread helper
@@ -497,6 +594,9 @@ EXPORT void aud_drct_seek(int time)
 
 EXPORT void InputPlugin::open_audio(int format, int rate, int channels)
 {
+    if (render_active())
+        return render_open_audio(format, rate, channels);
+
     // don't open audio if playback thread is lagging
     auto mh = mutex.take();
     if (!in_sync(mh))
@@ -527,6 +627,9 @@ EXPORT void InputPlugin::open_audio(int format, int rate, int channels)
 
 EXPORT void InputPlugin::set_replay_gain(const ReplayGainInfo & gain)
 {
+    if (render_active())
+        return render_set_replay_gain(gain);
+
     auto mh = mutex.take();
 
     pb_info.gain = gain;
@@ -538,6 +641,9 @@ EXPORT void InputPlugin::set_replay_gain(const ReplayGainInfo & gain)
 
 EXPORT void InputPlugin::write_audio(const void * data, int length)
 {
+    if (render_active())
+        return render_write_audio(data, length);
+
     auto mh = mutex.take();
     if (!in_sync(mh))
         return;
@@ -546,34 +652,53 @@ EXPORT void InputPlugin::write_audio(const void * data, int length)
     int a = pb_control.repeat_a;
     int b = pb_control.repeat_b;
 
-    mh.unlock();
+    while (1)
+    {
+        mh.unlock();
 
-    // it's okay to call output_write_audio() even if we are no longer in sync,
-    // since it will return immediately if output_flush() has been called
-    int stop_time = (b >= 0) ? b : pb_info.stop_time;
-    if (output_write_audio(data, length, stop_time))
-        return;
+        // it's okay to call output_write_audio() even if we are no longer in
+        // sync, since it will return immediately if output_flush() has been
+        // called
+        int stop_time = (b >= 0) ? b : pb_info.stop_time;
+        int written = 0;
+        if (output_write_audio(data, length, stop_time, &written))
+            return;
 
-    mh.lock();
+        mh.lock();
 
-    if (!in_sync(mh))
-        return;
+        if (!in_sync(mh))
+            return;
+
+        // if we are still in sync, then one of the following happened:
+        // 1. output_flush() was called due to a seek request
+        // 2. we've reached repeat point B
+        // 3. we've reached the end of a segmented track
+        if (pb_control.seek >= 0)
+            return;
 
-    // if we are still in sync, then one of the following happened:
-    // 1. output_flush() was called due to a seek request
-    // 2. we've reached repeat point B
-    // 3. we've reached the end of a segmented track
-    if (pb_control.seek < 0)
-    {
         if (b >= 0)
+        {
             request_seek(mh, a);
-        else
+            return;
+        }
+
+        if (!next_segment(mh))
+        {
             pb_info.ended = true;
+            return;
+        }
+
+        // write the rest of the data to the next segment
+        data = (const char *)data + written;
+        length -= written;
     }
 }
 
 EXPORT Tuple InputPlugin::get_playback_tuple()
 {
+    if (render_active())
+        return render_get_tuple();
+
     auto mh = mutex.take();
     Tuple tuple = pb_info.tuple.ref();
 
@@ -585,6 +710,9 @@ EXPORT Tuple InputPlugin::get_playback_tuple()
 
 EXPORT void InputPlugin::set_playback_tuple(Tuple && tuple)
 {
+    if (render_active())
+        return render_set_tuple(std::move(tuple));
+
     // due to mutex ordering, we cannot call into the playlist while locked;
     // instead, playback_entry_set_tuple() calls back into first
     // playback_check_serial() and then eventually playback_set_info()
@@ -593,6 +721,9 @@ EXPORT void InputPlugin::set_playback_tuple(Tuple && tuple)
 
 EXPORT void InputPlugin::set_stream_bitrate(int bitrate)
 {
+    if (render_active())
+        return;
+
     auto mh = mutex.take();
     pb_info.bitrate = bitrate;
 
@@ -602,12 +733,18 @@ EXPORT void InputPlugin::set_stream_bitrate(int bitrate)
 
 EXPORT bool InputPlugin::check_stop()
 {
+    if (render_active())
+        return render_check_stop();
+
     auto mh = mutex.take();
     return !is_ready(mh) || pb_info.ended || pb_info.error;
 }
 
 EXPORT int InputPlugin::check_seek()
 {
+    if (render_active())
+        return render_check_seek();
+
     auto mh = mutex.take();
     int seek = -1;
 
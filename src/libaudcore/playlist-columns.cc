@@ -0,0 +1,145 @@
+/*
+ * playlist-columns.cc
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "playlist-columns.h"
+
+#include <string.h>
+
+static const Tuple::Field int_fields[] = {Tuple::Length, Tuple::Year,
+                                          Tuple::Track, Tuple::Bitrate};
+
+static const Tuple::Field str_fields[] = {Tuple::Title,       Tuple::Artist,
+                                          Tuple::Album,       Tuple::AlbumArtist,
+                                          Tuple::Genre,       Tuple::Basename};
+
+RowSet::RowSet(int rows, bool set) : m_rows(rows)
+{
+    m_words.insert(0, (rows + 63) >> 6);
+
+    if (set && rows)
+    {
+        memset(m_words.begin(), 0xff, sizeof(uint64_t) * m_words.len());
+        if (rows & 63)
+            m_words[m_words.len() - 1] = ((uint64_t)1 << (rows & 63)) - 1;
+    }
+}
+
+int RowSet::count() const
+{
+    int count = 0;
+    for (uint64_t word : m_words)
+        count += __builtin_popcountll(word);
+
+    return count;
+}
+
+int PlaylistColumns::int_column(Tuple::Field field) // static
+{
+    for (int col = 0; col < n_int_columns; col++)
+    {
+        if (int_fields[col] == field)
+            return col;
+    }
+
+    return -1;
+}
+
+int PlaylistColumns::str_column(Tuple::Field field) // static
+{
+    for (int col = 0; col < n_str_columns; col++)
+    {
+        if (str_fields[col] == field)
+            return col;
+    }
+
+    return -1;
+}
+
+void PlaylistColumns::resize(int rows)
+{
+    for (auto & column : m_ints)
+        column.resize(rows);
+
+    for (auto & column : m_strs)
+    {
+        if (rows > m_rows)
+            column.insert(-1, rows - m_rows);
+        else if (rows < m_rows)
+            column.remove(rows, -1);
+    }
+
+    m_rows = rows;
+}
+
+void PlaylistColumns::set_row(int row, const Tuple & tuple)
+{
+    for (int col = 0; col < n_int_columns; col++)
+        m_ints[col][row] = tuple.get_int(int_fields[col]);
+
+    for (int col = 0; col < n_str_columns; col++)
+        m_strs[col][row] = tuple.get_str(str_fields[col]);
+}
+
+void PlaylistColumns::clear()
+{
+    for (auto & column : m_ints)
+        column.clear();
+    for (auto & column : m_strs)
+        column.clear();
+
+    m_rows = 0;
+}
+
+void PlaylistColumns::filter_int(int col, int min, int max, RowSet & set) const
+{
+    const int * column = m_ints[col].begin();
+    uint64_t * words = set.words();
+
+    /* build a 64-bit mask per word in a branch-free inner loop, which the
+     * compiler can vectorize */
+    for (int w = 0; w < set.n_words(); w++)
+    {
+        if (!words[w])
+            continue;
+
+        const int * values = column + (w << 6);
+        int n = aud::min(64, m_rows - (w << 6));
+        uint64_t mask = 0;
+
+        for (int i = 0; i < n; i++)
+            mask |= (uint64_t)(values[i] >= 0 && values[i] >= min &&
+                               values[i] <= max)
+                    << i;
+
+        words[w] &= mask;
+    }
+}
+
+int64_t PlaylistColumns::sum_int(int col, const RowSet & set) const
+{
+    const int * column = m_ints[col].begin();
+    int64_t sum = 0;
+
+    set.iterate([&](int row) {
+        if (column[row] > 0)
+            sum += column[row];
+    });
+
+    return sum;
+}
@@ -0,0 +1,128 @@
+/*
+ * playlist-columns.h
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef PLAYLIST_COLUMNS_H
+#define PLAYLIST_COLUMNS_H
+
+#include <stdint.h>
+
+#include "index.h"
+#include "multihash.h"
+#include "tuple.h"
+
+/* Fixed-size set of row numbers, stored as one bit per row. */
+class RowSet
+{
+public:
+    explicit RowSet(int rows, bool set = false);
+
+    int rows() const { return m_rows; }
+    int count() const;
+
+    bool get(int row) const { return (m_words[row >> 6] >> (row & 63)) & 1; }
+    void set(int row) { m_words[row >> 6] |= (uint64_t)1 << (row & 63); }
+    void clear(int row) { m_words[row >> 6] &= ~((uint64_t)1 << (row & 63)); }
+
+    // direct access for the filter kernels
+    uint64_t * words() { return m_words.begin(); }
+    const uint64_t * words() const { return m_words.begin(); }
+    int n_words() const { return m_words.len(); }
+
+    template<class F>
+    void iterate(F func) const
+    {
+        for (int w = 0; w < m_words.len(); w++)
+        {
+            for (uint64_t bits = m_words[w]; bits; bits &= bits - 1)
+                func((w << 6) + __builtin_ctzll(bits));
+        }
+    }
+
+private:
+    int m_rows;
+    Index<uint64_t> m_words;
+};
+
+/* Column-oriented copy of the metadata of a playlist, used to evaluate queries
+ * without visiting each entry's Tuple.  Integer fields are stored as plain
+ * arrays.  String fields are stored as pooled strings, which makes them
+ * dictionary-encoded for free: the string pointer serves as the code, so string
+ * predicates need to be evaluated only once per distinct value. */
+class PlaylistColumns
+{
+public:
+    /* returns the column number of <field>, or -1 if not stored */
+    static int int_column(Tuple::Field field);
+    static int str_column(Tuple::Field field);
+
+    int rows() const { return m_rows; }
+
+    void resize(int rows);
+    void set_row(int row, const Tuple & tuple);
+    void clear();
+
+    int get_int(int col, int row) const { return m_ints[col][row]; }
+    const String & get_str(int col, int row) const { return m_strs[col][row]; }
+
+    /* Clears the rows of <set> whose value of an integer field falls outside
+     * [min, max]; rows with the field unset (-1) always fail. */
+    void filter_int(int col, int min, int max, RowSet & set) const;
+
+    /* Clears the rows of <set> for which match(value) returns false; <match>
+     * is called at most once for each distinct value. */
+    template<class F>
+    void filter_str(int col, RowSet & set, F match) const
+    {
+        SimpleHash<String, bool> results;
+        const String * column = m_strs[col].begin();
+
+        for (int w = 0; w < set.n_words(); w++)
+        {
+            uint64_t bits = set.words()[w];
+
+            for (uint64_t b = bits; b; b &= b - 1)
+            {
+                int i = __builtin_ctzll(b);
+                const String & value = column[(w << 6) + i];
+
+                bool * result = value ? results.lookup(value) : nullptr;
+                if (value && !result)
+                    result = results.add(value, match(value));
+
+                if (!result || !*result)
+                    bits &= ~((uint64_t)1 << i);
+            }
+
+            set.words()[w] = bits;
+        }
+    }
+
+    /* Sums an integer field over the rows of <set>, skipping unset values. */
+    int64_t sum_int(int col, const RowSet & set) const;
+
+private:
+    static constexpr int n_int_columns = 4;
+    static constexpr int n_str_columns = 6;
+
+    int m_rows = 0;
+    Index<int> m_ints[n_int_columns];
+    Index<String> m_strs[n_str_columns];
+};
+
+#endif // PLAYLIST_COLUMNS_H
@@ -19,9 +19,13 @@
 
 #include "playlist-data.h"
 
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <glib.h> /* for GRegex */
+
+#include "audstrings.h"
 #include "runtime.h"
 #include "scanner.h"
 #include "tuple-compiler.h"
@@ -42,7 +46,15 @@ struct PlaylistEntry
     void format();
     void set_tuple(Tuple && new_tuple);
 
-    String filename;
+    /* builds the full filename (not pooled) */
+    StringBuf filename() const;
+    bool is_stdin() const { return !strncmp(folder, "stdin://", 8); }
+
+    /* The filename is stored split into folder and basename.  Entries in the
+     * same folder thus share a single (pooled) copy of the folder, which also
+     * serves as a cheap folder identifier.  The folder includes the trailing
+     * "/" and is never null. */
+    String folder, basename;
     PluginHandle * decoder;
     Tuple tuple;
     String error;
@@ -52,6 +64,21 @@ struct PlaylistEntry
     bool selected, queued;
 };
 
+static void split_filename(const char * filename, String & folder,
+                           String & basename)
+{
+    const char * slash = strrchr(filename, '/');
+    const char * base = slash ? slash + 1 : filename;
+
+    folder = String(str_copy(filename, base - filename));
+    basename = String(base);
+}
+
+StringBuf PlaylistEntry::filename() const
+{
+    return str_concat({folder, basename});
+}
+
 void PlaylistEntry::format()
 {
     tuple.delete_fallbacks();
@@ -77,7 +104,7 @@ void PlaylistEntry::set_tuple(Tuple && new_tuple)
     error = String();
 
     if (!new_tuple.valid())
-        new_tuple.set_filename(filename);
+        new_tuple.set_filename(String(filename()));
 
     length = aud::max(0, new_tuple.get_int(Tuple::Length));
     tuple = std::move(new_tuple);
@@ -86,14 +113,68 @@ void PlaylistEntry::set_tuple(Tuple && new_tuple)
 }
 
 PlaylistEntry::PlaylistEntry(PlaylistAddItem && item)
-    : filename(item.filename), decoder(item.decoder), number(-1), length(0),
-      shuffle_num(0), selected(false), queued(false)
+    : decoder(item.decoder), number(-1), length(0), shuffle_num(0),
+      selected(false), queued(false)
 {
+    split_filename(item.filename, folder, basename);
     set_tuple(std::move(item.tuple));
 }
 
 PlaylistEntry::~PlaylistEntry() { pl_signal_entry_deleted(this); }
 
+/* The track table indexes the entries of all playlists by URI.  Entries
+ * referring to the same file share their scan results (and, through
+ * reference counting, a single copy of their metadata), so that each file is
+ * scanned only once no matter how many playlists contain it.  Like the rest of
+ * PlaylistData, the table is protected by the playlist mutex. */
+struct TrackKey
+{
+    String folder, basename;
+
+    bool operator==(const TrackKey & b) const
+    {
+        return folder == b.folder && basename == b.basename;
+    }
+
+    unsigned hash() const { return folder.hash() + basename.hash(); }
+};
+
+struct TrackRef
+{
+    PlaylistData * playlist;
+    PlaylistEntry * entry;
+};
+
+static SimpleHash<TrackKey, Index<TrackRef>> s_tracks;
+
+static Index<TrackRef> * lookup_track(const PlaylistEntry * entry)
+{
+    return s_tracks.lookup({entry->folder, entry->basename});
+}
+
+static void add_track_ref(PlaylistData * playlist, PlaylistEntry * entry)
+{
+    TrackKey key = {entry->folder, entry->basename};
+    auto refs = s_tracks.lookup(key);
+    if (!refs)
+        refs = s_tracks.add(key, Index<TrackRef>());
+
+    refs->append(playlist, entry);
+}
+
+static void remove_track_ref(PlaylistEntry * entry)
+{
+    TrackKey key = {entry->folder, entry->basename};
+    auto refs = s_tracks.lookup(key);
+    if (!refs)
+        return;
+
+    refs->remove_if([entry](const TrackRef & ref) { return ref.entry == entry; });
+
+    if (!refs->len())
+        s_tracks.remove(key);
+}
+
 void PlaylistData::update_formatter() // static
 {
     s_tuple_formatter.compile(aud_get_str("generic_title_format"));
@@ -107,14 +188,17 @@ void PlaylistData::cleanup_formatter() // static
 
 void PlaylistData::delete_entry(PlaylistEntry * entry) // static
 {
+    remove_track_ref(entry);
     delete entry;
 }
 
 PlaylistData::PlaylistData(Playlist::ID * id, const char * title)
-    : modified(true), scan_status(NotScanning), title(title), resume_time(0),
+    : modified(true), scan_status(NotScanning), visible_at(0),
+      visible_count(0), title(title), resume_time(0),
       m_id(id), m_position(nullptr), m_focus(nullptr), m_selected_count(0),
       m_last_shuffle_num(0), m_total_length(0), m_selected_length(0),
-      m_last_update(), m_next_update(), m_position_changed(false)
+      m_last_update(), m_next_update(), m_position_changed(false),
+      m_columns_active(false)
 {
 }
 
@@ -122,8 +206,31 @@ PlaylistData::~PlaylistData() { pl_signal_playlist_deleted(m_id); }
 
 void PlaylistData::number_entries(int at, int length)
 {
+    if (m_columns_active)
+        m_columns.resize(m_entries.len());
+
     for (int i = at; i < at + length; i++)
+    {
         m_entries[i]->number = i;
+
+        if (m_columns_active)
+            m_columns.set_row(i, m_entries[i]->tuple);
+    }
+}
+
+void PlaylistData::activate_columns()
+{
+    if (!m_columns_active)
+    {
+        m_columns_active = true;
+        number_entries(0, m_entries.len());
+    }
+}
+
+void PlaylistData::update_columns(PlaylistEntry * entry)
+{
+    if (m_columns_active && entry->number >= 0)
+        m_columns.set_row(entry->number, entry->tuple);
 }
 
 PlaylistEntry * PlaylistData::entry_at(int i)
@@ -139,7 +246,21 @@ const PlaylistEntry * PlaylistData::entry_at(int i) const
 String PlaylistData::entry_filename(int i) const
 {
     auto entry = entry_at(i);
-    return entry ? entry->filename : String();
+    return entry ? String(entry->filename()) : String();
+}
+
+void PlaylistData::snapshot_entries(
+    Index<PlaylistSnapshot::Entry> & entries) const
+{
+    entries.insert(0, m_entries.len());
+
+    for (int i = 0; i < m_entries.len(); i++)
+    {
+        auto & entry = m_entries[i];
+        entries[i].folder = entry->folder;
+        entries[i].basename = entry->basename;
+        entries[i].tuple = entry->tuple.ref();
+    }
 }
 
 PluginHandle * PlaylistData::entry_decoder(int i, String * error) const
@@ -158,12 +279,6 @@ Tuple PlaylistData::entry_tuple(int i, String * error) const
     return entry ? entry->tuple.ref() : Tuple();
 }
 
-static bool same_album(const Tuple & a, const Tuple & b)
-{
-    String album = a.get_str(Tuple::Album);
-    return (album && album == b.get_str(Tuple::Album));
-}
-
 void PlaylistData::set_entry_tuple(PlaylistEntry * entry, Tuple && tuple)
 {
     m_total_length -= entry->length;
@@ -175,6 +290,8 @@ void PlaylistData::set_entry_tuple(PlaylistEntry * entry, Tuple && tuple)
     m_total_length += entry->length;
     if (entry->selected)
         m_selected_length += entry->length;
+
+    update_columns(entry);
 }
 
 void PlaylistData::queue_update(Playlist::UpdateLevel level, int at, int count,
@@ -237,12 +354,18 @@ void PlaylistData::insert_items(int at, Index<PlaylistAddItem> && items)
         auto entry = new PlaylistEntry(std::move(item));
         m_entries[i++].capture(entry);
         m_total_length += entry->length;
+
+        add_track_ref(this, entry);
     }
 
     items.clear();
 
     number_entries(at, n_entries + n_items - at);
     queue_update(Playlist::Structure, at, n_items);
+
+    // reuse metadata of files already present in another playlist
+    for (i = at; i < at + n_items; i++)
+        fill_from_library(m_entries[i].get(), 0);
 }
 
 void PlaylistData::remove_entries(int at, int number)
@@ -560,17 +683,143 @@ void PlaylistData::remove_selected()
 void PlaylistData::sort_entries(Index<EntryPtr> & entries,
                                 const CompareData & data) // static
 {
-    entries.sort([data](const EntryPtr & a, const EntryPtr & b) {
-        if (data.filename_compare)
-            return data.filename_compare(a->filename, b->filename);
+    if (!data.filename_compare)
+    {
+        entries.sort(
+            [data](const EntryPtr & a, const EntryPtr & b) {
+                return data.tuple_compare(a->tuple, b->tuple);
+            },
+            data.parallel);
+
+        return;
+    }
+
+    // build each filename once, rather than once per comparison; the
+    // filenames are only needed during the sort, so they are kept in a single
+    // buffer rather than added to the string pool
+    struct SortItem
+    {
+        int offset;
+        EntryPtr entry;
+    };
+
+    Index<char> names;
+    Index<SortItem> items;
+
+    for (auto & entry : entries)
+    {
+        int offset = names.len();
+        int folder_len = strlen(entry->folder);
+        int base_len = strlen(entry->basename);
+
+        names.insert(entry->folder, -1, folder_len);
+        names.insert(entry->basename, -1, base_len + 1);
+
+        items.append(offset, std::move(entry));
+    }
+
+    items.sort(
+        [data, &names](const SortItem & a, const SortItem & b) {
+            return data.filename_compare(&names[a.offset], &names[b.offset]);
+        },
+        data.parallel);
+
+    for (int i = 0; i < items.len(); i++)
+        entries[i] = std::move(items[i].entry);
+}
+
+static bool can_sort_by_column(const PlaylistData::CompareData & data)
+{
+    return !data.filename_compare &&
+           (PlaylistColumns::int_column(data.field) >= 0 ||
+            PlaylistColumns::str_column(data.field) >= 0);
+}
+
+/* Sorts by a field kept in the column store, comparing integer keys instead of
+ * calling tuple_compare.  String values are ranked once per distinct value.
+ * The order is the same as that of the built-in comparison functions: unset
+ * values first, then ascending (by str_compare() for strings).  The column
+ * store must be active and the entries still numbered. */
+void PlaylistData::sort_by_column(Index<EntryPtr> & entries,
+                                  const CompareData & data)
+{
+    int int_col = PlaylistColumns::int_column(data.field);
+    int str_col = PlaylistColumns::str_column(data.field);
+
+    struct SortItem
+    {
+        int key;
+        EntryPtr entry;
+    };
+
+    SimpleHash<String, int> ranks;
+
+    if (str_col >= 0)
+    {
+        Index<String> values;
+
+        for (auto & entry : entries)
+        {
+            const String & value = m_columns.get_str(str_col, entry->number);
+            if (value && !ranks.lookup(value))
+            {
+                ranks.add(value, 0);
+                values.append(value);
+            }
+        }
+
+        values.sort(
+            [](const String & a, const String & b) {
+                return str_compare(a, b);
+            },
+            true);
+
+        int rank = 0;
+        for (int i = 0; i < values.len(); i++)
+        {
+            if (i > 0 && str_compare(values[i - 1], values[i]))
+                rank++;
+
+            *ranks.lookup(values[i]) = rank;
+        }
+    }
+
+    Index<SortItem> items;
+
+    for (auto & entry : entries)
+    {
+        int key;
+
+        if (str_col >= 0)
+        {
+            const String & value = m_columns.get_str(str_col, entry->number);
+            key = value ? *ranks.lookup(value) : -1;
+        }
         else
-            return data.tuple_compare(a->tuple, b->tuple);
-    });
+            key = m_columns.get_int(int_col, entry->number);
+
+        items.append(key, std::move(entry));
+    }
+
+    items.sort(
+        [](const SortItem & a, const SortItem & b) {
+            return (a.key < b.key) ? -1 : (a.key > b.key);
+        },
+        true);
+
+    for (int i = 0; i < items.len(); i++)
+        entries[i] = std::move(items[i].entry);
 }
 
 void PlaylistData::sort(const CompareData & data)
 {
-    sort_entries(m_entries, data);
+    if (can_sort_by_column(data))
+    {
+        activate_columns();
+        sort_by_column(m_entries, data);
+    }
+    else
+        sort_entries(m_entries, data);
 
     number_entries(0, m_entries.len());
     queue_update(Playlist::Structure, 0, m_entries.len());
@@ -579,6 +828,10 @@ void PlaylistData::sort(const CompareData & data)
 void PlaylistData::sort_selected(const CompareData & data)
 {
     int n_entries = m_entries.len();
+    bool by_column = can_sort_by_column(data);
+
+    if (by_column)
+        activate_columns();
 
     Index<EntryPtr> selected;
 
@@ -588,7 +841,10 @@ void PlaylistData::sort_selected(const CompareData & data)
             selected.append(std::move(entry));
     }
 
-    sort_entries(selected, data);
+    if (by_column)
+        sort_by_column(selected, data);
+    else
+        sort_entries(selected, data);
 
     int i = 0;
     for (auto & entry : m_entries)
@@ -832,7 +1088,7 @@ PlaylistData::PosChange PlaylistData::shuffle_pos_after(int ref_pos,
     {
         // look for the next entry in the album
         auto next = entry_at(ref_pos + 1);
-        if (next && same_album(next->tuple, ref_entry->tuple))
+        if (next && next->tuple.same_album(ref_entry->tuple))
             return {ref_pos + 1, true};
     }
 
@@ -851,7 +1107,7 @@ PlaylistData::PosChange PlaylistData::shuffle_pos_random(bool repeat,
         // optionally skip all but first entry in album
         if ((entry->shuffle_num == 0 || repeat) &&
             !(by_album && prev_entry &&
-              same_album(entry->tuple, prev_entry->tuple)))
+              entry->tuple.same_album(prev_entry->tuple)))
         {
             choices.append(entry.get());
         }
@@ -1041,7 +1297,7 @@ bool PlaylistData::prev_album()
         while (1)
         {
             auto prev_entry = entry_at(pos_before(pos, shuffle));
-            if (!prev_entry || !same_album(entry->tuple, prev_entry->tuple))
+            if (!prev_entry || !entry->tuple.same_album(prev_entry->tuple))
                 break;
 
             pos = prev_entry->number;
@@ -1080,7 +1336,7 @@ bool PlaylistData::next_album(bool repeat)
         change = pos_after(change.new_pos, shuffle, true);
 
         auto next_entry = entry_at(change.new_pos);
-        if (!next_entry || !same_album(entry->tuple, next_entry->tuple))
+        if (!next_entry || !entry->tuple.same_album(next_entry->tuple))
             break;
 
         skipped.append(change);
@@ -1108,17 +1364,108 @@ bool PlaylistData::next_album(bool repeat)
     return true;
 }
 
-int PlaylistData::next_unscanned_entry(int entry_num) const
+// returns the position that next_song() would move to, provided that it is the
+// following segment of the same audio file (e.g. the next track of a cuesheet)
+PlaylistData::PosChange PlaylistData::next_segment_change() const
+{
+    if (!m_position || !m_position->decoder)
+        return NO_POS;
+
+    bool shuffle = aud_get_bool("shuffle");
+    bool by_album = aud_get_bool("album_shuffle");
+
+    auto change = pos_after(m_position->number, shuffle, by_album);
+    auto next = entry_at(change.new_pos);
+    if (!next || next->decoder != m_position->decoder)
+        return NO_POS;
+
+    const Tuple & tuple = m_position->tuple;
+    const Tuple & next_tuple = next->tuple;
+
+    int end_time = tuple.get_int(Tuple::EndTime);
+    String audio_file = tuple.get_str(Tuple::AudioFile);
+
+    if (end_time <= 0 || !audio_file ||
+        next_tuple.get_int(Tuple::StartTime) != end_time ||
+        next_tuple.get_str(Tuple::AudioFile) != audio_file)
+        return NO_POS;
+
+    return change;
+}
+
+int PlaylistData::next_segment_pos() const
+{
+    return next_segment_change().new_pos;
+}
+
+bool PlaylistData::next_segment()
+{
+    auto change = next_segment_change();
+    if (change.new_pos < 0)
+        return false;
+
+    change_position(change);
+    queue_position_change();
+    return true;
+}
+
+// returns (up to <count>) entries that are expected to be played after the
+// current one, stopping where the order is not yet decided (i.e. at a random
+// pick in shuffle mode)
+Index<int> PlaylistData::upcoming_entries(int count) const
+{
+    Index<int> entries;
+    if (!m_position)
+        return entries;
+
+    for (auto entry : m_queued)
+    {
+        if (entries.len() >= count)
+            return entries;
+        if (entry != m_position)
+            entries.append(entry->number);
+    }
+
+    if (aud_get_bool("no_playlist_advance"))
+        return entries;
+
+    bool shuffle = aud_get_bool("shuffle");
+    bool by_album = aud_get_bool("album_shuffle");
+
+    // playback continues from the last queued entry
+    int pos = m_queued.len() ? m_queued[m_queued.len() - 1]->number
+                             : m_position->number;
+
+    while (entries.len() < count)
+    {
+        if (shuffle)
+            pos = shuffle_pos_after(pos, by_album).new_pos;
+        else
+            pos = (pos + 1 < m_entries.len()) ? pos + 1 : -1;
+
+        if (pos < 0)
+            break;
+
+        entries.append(pos);
+    }
+
+    return entries;
+}
+
+int PlaylistData::next_unscanned_entry(int entry_num, int end) const
 {
     if (entry_num < 0)
         return -1;
 
-    for (; entry_num < m_entries.len(); entry_num++)
+    if (end < 0 || end > m_entries.len())
+        end = m_entries.len();
+
+    for (; entry_num < end; entry_num++)
     {
         auto & entry = *m_entries[entry_num];
 
         if (entry.tuple.state() == Tuple::Initial &&
-            strncmp(entry.filename, "stdin://", 8)) // blacklist stdin
+            !entry.is_stdin()) // blacklist stdin
         {
             return entry_num;
         }
@@ -1136,7 +1483,8 @@ ScanRequest * PlaylistData::create_scan_request(PlaylistEntry * entry,
         flags |= SCAN_TUPLE;
 
     /* scanner uses Tuple::AudioFile from existing tuple, if valid */
-    return new ScanRequest(entry->filename, flags, callback, entry->decoder,
+    return new ScanRequest(String(entry->filename()), flags, callback,
+                           entry->decoder,
                            (flags & SCAN_TUPLE) ? Tuple() : entry->tuple.ref());
 }
 
@@ -1161,6 +1509,65 @@ void PlaylistData::update_entry_from_scan(PlaylistEntry * entry,
         entry->tuple.set_state(Tuple::Failed);
         queue_update(Playlist::Metadata, entry->number, 1, update_flags);
     }
+
+    // share the results with other entries for the same file
+    for (auto & ref : *lookup_track(entry))
+    {
+        if (ref.entry != entry)
+            ref.playlist->copy_scan_results(ref.entry, entry, update_flags);
+    }
+}
+
+void PlaylistData::copy_scan_results(PlaylistEntry * entry,
+                                     const PlaylistEntry * source,
+                                     int update_flags)
+{
+    if (!entry->decoder)
+        entry->decoder = source->decoder;
+
+    if (entry->tuple.state() != Tuple::Initial ||
+        source->tuple.state() == Tuple::Initial)
+        return;
+
+    /* the source tuple has already been formatted; since formatting does not
+     * depend on the playlist, it can be shared as-is */
+    m_total_length -= entry->length;
+    if (entry->selected)
+        m_selected_length -= entry->length;
+
+    entry->tuple = source->tuple.ref();
+    entry->length = source->length;
+    entry->error = source->error;
+
+    m_total_length += entry->length;
+    if (entry->selected)
+        m_selected_length += entry->length;
+
+    update_columns(entry);
+    queue_update(Playlist::Metadata, entry->number, 1, update_flags);
+}
+
+bool PlaylistData::fill_from_library(PlaylistEntry * entry, int update_flags)
+{
+    if (entry->tuple.state() != Tuple::Initial || entry->is_stdin())
+        return false;
+
+    for (auto & ref : *lookup_track(entry))
+    {
+        if (ref.entry->tuple.state() != Tuple::Initial)
+        {
+            copy_scan_results(entry, ref.entry, update_flags);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool PlaylistData::same_file(const PlaylistEntry * a,
+                             const PlaylistEntry * b) // static
+{
+    return a->folder == b->folder && a->basename == b->basename;
 }
 
 void PlaylistData::update_playback_entry(Tuple && tuple)
@@ -1176,7 +1583,7 @@ void PlaylistData::update_playback_entry(Tuple && tuple)
 bool PlaylistData::entry_needs_rescan(PlaylistEntry * entry, bool need_decoder,
                                       bool need_tuple)
 {
-    if (!strncmp(entry->filename, "stdin://", 8)) // blacklist stdin
+    if (entry->is_stdin()) // blacklist stdin
         return false;
 
     // check whether requested data (decoder and/or tuple) has been read
@@ -1184,42 +1591,158 @@ bool PlaylistData::entry_needs_rescan(PlaylistEntry * entry, bool need_decoder,
            (need_tuple && !entry->tuple.valid());
 }
 
+RowSet PlaylistData::run_query(const Playlist::Query & query)
+{
+    activate_columns();
+
+    RowSet rows(m_entries.len(), true);
+
+    for (auto field : Tuple::all_fields())
+    {
+        int col;
+
+        if ((col = PlaylistColumns::str_column(field)) >= 0)
+        {
+            String pattern = query.patterns.get_str(field);
+            GRegex * regex;
+
+            if (!pattern || !pattern[0] ||
+                !(regex = g_regex_new(pattern, G_REGEX_CASELESS,
+                                      (GRegexMatchFlags)0, nullptr)))
+                continue;
+
+            m_columns.filter_str(col, rows, [regex](const char * value) {
+                return (bool)g_regex_match(regex, value, (GRegexMatchFlags)0,
+                                           nullptr);
+            });
+
+            g_regex_unref(regex);
+        }
+        else if ((col = PlaylistColumns::int_column(field)) >= 0)
+        {
+            bool have_min = query.min.is_set(field);
+            bool have_max = query.max.is_set(field);
+
+            if (have_min || have_max)
+                m_columns.filter_int(
+                    col, have_min ? query.min.get_int(field) : INT_MIN,
+                    have_max ? query.max.get_int(field) : INT_MAX, rows);
+        }
+    }
+
+    return rows;
+}
+
+Index<int> PlaylistData::query_entries(const Playlist::Query & query)
+{
+    RowSet rows = run_query(query);
+
+    Index<int> entries;
+    rows.iterate([&](int row) { entries.append(row); });
+    return entries;
+}
+
+Index<Playlist::QueryGroup> PlaylistData::query_totals(
+    const Playlist::Query & query, Tuple::Field group_by)
+{
+    Index<Playlist::QueryGroup> groups;
+
+    int col = PlaylistColumns::str_column(group_by);
+    if (col < 0)
+        return groups;
+
+    RowSet rows = run_query(query);
+    int length_col = PlaylistColumns::int_column(Tuple::Length);
+
+    // maps each distinct value to its position in <groups>
+    SimpleHash<String, int> positions;
+    int unset_pos = -1;
+
+    rows.iterate([&](int row) {
+        const String & value = m_columns.get_str(col, row);
+        int length = aud::max(0, m_columns.get_int(length_col, row));
+
+        int * found = value ? positions.lookup(value)
+                            : (unset_pos >= 0 ? &unset_pos : nullptr);
+        int pos = found ? *found : groups.len();
+
+        if (!found)
+        {
+            groups.append(value, 0, (int64_t)0);
+
+            if (value)
+                positions.add(value, int(pos));
+            else
+                unset_pos = pos;
+        }
+
+        auto & group = groups[pos];
+        group.entries++;
+        group.length += length;
+    });
+
+    return groups;
+}
+
 void PlaylistData::reformat_titles()
 {
     for (auto & entry : m_entries)
+    {
         entry->format();
+        update_columns(entry.get());
+    }
 
     queue_update(Playlist::Metadata, 0, m_entries.len());
 }
 
 void PlaylistData::reset_tuples(bool selected_only)
 {
+    Index<PlaylistData *> others;
+
     for (auto & entry : m_entries)
     {
-        if (!selected_only || entry->selected)
-            set_entry_tuple(entry.get(), Tuple());
+        if (selected_only && !entry->selected)
+            continue;
+
+        /* reset every entry referring to the same file, including those in
+         * other playlists; otherwise fill_from_library() would just copy the
+         * old scan results back */
+        for (auto & ref : *lookup_track(entry.get()))
+        {
+            ref.playlist->set_entry_tuple(ref.entry, Tuple());
+
+            if (ref.playlist != this)
+            {
+                ref.playlist->queue_update(Playlist::Metadata,
+                                           ref.entry->number, 1);
+                if (others.find(ref.playlist) < 0)
+                    others.append(ref.playlist);
+            }
+        }
     }
 
     queue_update(Playlist::Metadata, 0, m_entries.len());
     pl_signal_rescan_needed(m_id);
+
+    for (PlaylistData * other : others)
+        pl_signal_rescan_needed(other->m_id);
 }
 
-void PlaylistData::reset_tuple_of_file(const char * filename)
+void PlaylistData::reset_tuple_of_file(const char * filename) // static
 {
-    bool found = false;
+    String folder, basename;
+    split_filename(filename, folder, basename);
 
-    for (auto & entry : m_entries)
+    auto refs = s_tracks.lookup({folder, basename});
+    if (!refs)
+        return;
+
+    for (auto & ref : *refs)
     {
-        if (!strcmp(entry->filename, filename))
-        {
-            set_entry_tuple(entry.get(), Tuple());
-            queue_update(Playlist::Metadata, entry->number, 1);
-            found = true;
-        }
+        ref.playlist->set_entry_tuple(ref.entry, Tuple());
+        ref.playlist->queue_update(Playlist::Metadata, ref.entry->number, 1);
+        pl_signal_rescan_needed(ref.playlist->m_id);
     }
-
-    if (found)
-        pl_signal_rescan_needed(m_id);
 }
 
 PlaylistEntry * PlaylistData::find_unselected_focus()
@@ -20,7 +20,8 @@
 #ifndef PLAYLIST_DATA_H
 #define PLAYLIST_DATA_H
 
-#include "playlist.h"
+#include "playlist-columns.h"
+#include "playlist-internal.h"
 #include "scanner.h"
 
 class TupleCompiler;
@@ -48,6 +49,10 @@ public:
     {
         Playlist::StringCompareFunc filename_compare;
         Playlist::TupleCompareFunc tuple_compare;
+        bool parallel; /* comparison function is thread-safe */
+        /* field compared by tuple_compare (built-in functions only), which
+         * allows sorting by the column store, or Tuple::Invalid */
+        Tuple::Field field;
     };
 
     PlaylistData(Playlist::ID * m_id, const char * title);
@@ -57,6 +62,7 @@ public:
     const PlaylistEntry * entry_at(int i) const;
 
     String entry_filename(int i) const;
+    void snapshot_entries(Index<PlaylistSnapshot::Entry> & entries) const;
     PluginHandle * entry_decoder(int i, String * error = nullptr) const;
     Tuple entry_tuple(int i, String * error = nullptr) const;
 
@@ -105,7 +111,13 @@ public:
     bool prev_album();
     bool next_album(bool repeat);
 
-    int next_unscanned_entry(int entry_num) const;
+    int next_segment_pos() const;
+    bool next_segment();
+
+    Index<int> upcoming_entries(int count) const;
+
+    /* searches [entry_num, end); end = -1 searches to the end */
+    int next_unscanned_entry(int entry_num, int end = -1) const;
     bool entry_needs_rescan(PlaylistEntry * entry, bool need_decoder,
                             bool need_tuple);
     ScanRequest * create_scan_request(PlaylistEntry * entry,
@@ -115,9 +127,16 @@ public:
                                 int update_flags);
     void update_playback_entry(Tuple && tuple);
 
+    bool fill_from_library(PlaylistEntry * entry, int update_flags);
+    static bool same_file(const PlaylistEntry * a, const PlaylistEntry * b);
+
+    Index<int> query_entries(const Playlist::Query & query);
+    Index<Playlist::QueryGroup> query_totals(const Playlist::Query & query,
+                                             Tuple::Field group_by);
+
     void reformat_titles();
     void reset_tuples(bool selected_only);
-    void reset_tuple_of_file(const char * filename);
+    static void reset_tuple_of_file(const char * filename);
 
     Playlist::ID * id() const { return m_id; }
 
@@ -147,6 +166,11 @@ private:
     typedef SmartPtr<PlaylistEntry, delete_entry> EntryPtr;
 
     void number_entries(int at, int length);
+    void activate_columns();
+    void update_columns(PlaylistEntry * entry);
+    void copy_scan_results(PlaylistEntry * entry, const PlaylistEntry * source,
+                           int update_flags);
+    RowSet run_query(const Playlist::Query & query);
     void set_entry_tuple(PlaylistEntry * entry, Tuple && tuple);
     void queue_update(Playlist::UpdateLevel level, int at, int count,
                       int flags = 0);
@@ -154,6 +178,7 @@ private:
 
     static void sort_entries(Index<EntryPtr> & entries,
                              const CompareData & data);
+    void sort_by_column(Index<EntryPtr> & entries, const CompareData & data);
 
     int shuffle_pos_before(int ref_pos) const;
     PosChange shuffle_pos_after(int ref_pos, bool by_album) const;
@@ -168,6 +193,7 @@ private:
 
     void change_position(PosChange change);
     bool change_position_to_next(bool repeat, int hint_pos);
+    PosChange next_segment_change() const;
     void shuffle_reset();
 
     PlaylistEntry * find_unselected_focus();
@@ -175,6 +201,7 @@ private:
 public:
     bool modified;
     ScanStatus scan_status;
+    int visible_at, visible_count; /* entries shown by the interface */
     String filename, title;
     int resume_time;
 
@@ -188,6 +215,10 @@ private:
     int64_t m_total_length, m_selected_length;
     Playlist::Update m_last_update, m_next_update;
     bool m_position_changed;
+
+    // built on first query, then kept in sync with m_entries
+    PlaylistColumns m_columns;
+    bool m_columns_active;
 };
 
 /* callbacks or "signals" (in the QObject sense) */
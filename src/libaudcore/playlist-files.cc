@@ -118,6 +118,10 @@ EXPORT bool Playlist::save_to_file(const char * filename, GetMode mode) const
 {
     String title = get_title();
 
+    // scan all the missing entries at once rather than one by one
+    if (mode == Wait)
+        wait_for_entries(0, -1, false, true);
+
     Index<PlaylistAddItem> items;
     items.insert(0, n_entries());
 
@@ -130,6 +134,13 @@ EXPORT bool Playlist::save_to_file(const char * filename, GetMode mode) const
         i++;
     }
 
+    return playlist_save(filename, title, items);
+}
+
+// may be called from any thread
+bool playlist_save(const char * filename, const char * title,
+                   const Index<PlaylistAddItem> & items)
+{
     AUDINFO("Saving playlist %s.\n", filename);
 
     StringBuf ext = uri_get_extension(filename);
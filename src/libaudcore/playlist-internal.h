@@ -33,6 +33,20 @@ struct DecodeInfo
     String error;
 };
 
+/* copy of a playlist's contents, taken by the main thread and saved by a
+ * background thread; the strings and tuple are shared, not duplicated */
+struct PlaylistSnapshot
+{
+    struct Entry
+    {
+        String folder, basename;
+        Tuple tuple;
+    };
+
+    String title;
+    Index<Entry> entries;
+};
+
 /* extended handle for accessing internal playlist functions */
 class PlaylistEx : public Playlist
 {
@@ -47,6 +61,16 @@ public:
     bool get_modified() const;
     void set_modified(bool modified) const;
 
+    /* Like sort_by_filename(), etc., but the comparison function (exactly one
+     * of which is given) may be called from several threads at once.  If
+     * tuple_compare is a plain comparison of <field>, the sort may use the
+     * column store instead of calling it. */
+    void sort_parallel(StringCompareFunc filename_compare,
+                       TupleCompareFunc tuple_compare, Tuple::Field field,
+                       bool selected_only = false) const;
+
+    PlaylistSnapshot snapshot() const;
+
     bool insert_flat_playlist(const char * filename) const;
     void insert_flat_items(int at, Index<PlaylistAddItem> && items) const;
 };
@@ -61,6 +85,8 @@ void playlist_load_state();
 void playlist_save_state();
 
 DecodeInfo playback_entry_read(int serial);
+Tuple playback_entry_next_segment(int serial);
+bool playback_entry_continue();
 void playback_entry_set_tuple(int serial, Tuple && tuple);
 
 /* playlist-cache.cc */
@@ -70,8 +96,11 @@ void playlist_cache_clear(void * = nullptr);
 /* playlist-files.cc */
 bool playlist_load(const char * filename, String & title,
                    Index<PlaylistAddItem> & items);
+bool playlist_save(const char * filename, const char * title,
+                   const Index<PlaylistAddItem> & items);
 
 /* playlist-utils.cc */
+void load_playlists_start();
 void load_playlists();
 void save_playlists(bool exiting);
 
@@ -19,6 +19,7 @@
 
 #include "playlist-internal.h"
 
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -26,8 +27,10 @@
 
 #include "audstrings.h"
 #include "hook.h"
+#include "internal.h"
 #include "multihash.h"
 #include "runtime.h"
+#include "threads.h"
 #include "tuple.h"
 #include "vfs.h"
 
@@ -151,24 +154,40 @@ static const Playlist::TupleCompareFunc tuple_comparisons[] = {
     tuple_compare_length,
     tuple_compare_comment};
 
+// fields compared by the functions above
+static const Tuple::Field sort_fields[] = {
+    Tuple::Invalid,        // path
+    Tuple::Invalid,        // filename
+    Tuple::Title,          // title
+    Tuple::Album,          // album
+    Tuple::Artist,         // artist
+    Tuple::AlbumArtist,    // album artist
+    Tuple::Year,           // date
+    Tuple::Genre,          // genre
+    Tuple::Track,          // track
+    Tuple::FormattedTitle, // formatted title
+    Tuple::Length,         // length
+    Tuple::Comment         // comment
+};
+
 static_assert(aud::n_elems(filename_comparisons) == Playlist::n_sort_types &&
-                  aud::n_elems(tuple_comparisons) == Playlist::n_sort_types,
+                  aud::n_elems(tuple_comparisons) == Playlist::n_sort_types &&
+                  aud::n_elems(sort_fields) == Playlist::n_sort_types,
               "Update playlist comparison functions");
 
+/* the built-in comparison functions are thread-safe */
 EXPORT void Playlist::sort_entries(SortType scheme) const
 {
-    if (filename_comparisons[scheme])
-        sort_by_filename(filename_comparisons[scheme]);
-    else if (tuple_comparisons[scheme])
-        sort_by_tuple(tuple_comparisons[scheme]);
+    PlaylistEx(*this).sort_parallel(filename_comparisons[scheme],
+                                    tuple_comparisons[scheme],
+                                    sort_fields[scheme]);
 }
 
 EXPORT void Playlist::sort_selected(SortType scheme) const
 {
-    if (filename_comparisons[scheme])
-        sort_selected_by_filename(filename_comparisons[scheme]);
-    else if (tuple_comparisons[scheme])
-        sort_selected_by_tuple(tuple_comparisons[scheme]);
+    PlaylistEx(*this).sort_parallel(filename_comparisons[scheme],
+                                    tuple_comparisons[scheme],
+                                    sort_fields[scheme], true);
 }
 
 /* FIXME: this considers empty fields as duplicates */
@@ -184,7 +203,7 @@ EXPORT void Playlist::remove_duplicates(SortType scheme) const
     {
         StringCompareFunc compare = filename_comparisons[scheme];
 
-        sort_by_filename(compare);
+        PlaylistEx(*this).sort_parallel(compare, nullptr, Tuple::Invalid);
         String last = entry_filename(0);
 
         for (int i = 1; i < entries; i++)
@@ -201,7 +220,8 @@ EXPORT void Playlist::remove_duplicates(SortType scheme) const
     {
         TupleCompareFunc compare = tuple_comparisons[scheme];
 
-        sort_by_tuple(compare);
+        wait_for_entries(0, -1, false, true);
+        PlaylistEx(*this).sort_parallel(nullptr, compare, sort_fields[scheme]);
         Tuple last = entry_tuple(0);
 
         for (int i = 1; i < entries; i++)
@@ -220,18 +240,45 @@ EXPORT void Playlist::remove_duplicates(SortType scheme) const
 
 EXPORT void Playlist::remove_unavailable() const
 {
-    int entries = n_entries();
+    auto entries = PlaylistEx(*this).snapshot().entries;
 
     select_all(false);
 
-    for (int i = 0; i < entries; i++)
+    /* entries are usually grouped by folder, so once a file is found missing,
+     * check whether its entire folder is gone and skip testing the rest; the
+     * folders are pooled strings and can be compared by pointer */
+    const char * folder = nullptr;
+    bool folder_tested = false, folder_missing = false;
+
+    for (int i = 0; i < entries.len(); i++)
     {
-        String filename = entry_filename(i);
+        auto & entry = entries[i];
+
+        if ((const char *)entry.folder != folder)
+        {
+            folder = entry.folder;
+            folder_tested = folder_missing = false;
+        }
+
+        if (folder_missing)
+        {
+            select_entry(i, true);
+            continue;
+        }
 
         /* use VFS_NO_ACCESS since VFS_EXISTS doesn't distinguish between
          * inaccessible files and URI schemes that don't support file_test() */
+        StringBuf filename = str_concat({entry.folder, entry.basename});
         if (VFSFile::test_file(filename, VFS_NO_ACCESS))
+        {
             select_entry(i, true);
+
+            if (!folder_tested)
+            {
+                folder_missing = VFSFile::test_file(folder, VFS_NO_ACCESS);
+                folder_tested = true;
+            }
+        }
     }
 
     remove_selected();
@@ -239,36 +286,13 @@ EXPORT void Playlist::remove_unavailable() const
 
 EXPORT void Playlist::select_by_patterns(const Tuple & patterns) const
 {
-    int entries = n_entries();
-
-    select_all(true);
-
-    for (Tuple::Field field :
-         {Tuple::Title, Tuple::Album, Tuple::Artist, Tuple::Basename})
-    {
-        String pattern = patterns.get_str(field);
-        GRegex * regex;
-
-        if (!pattern || !pattern[0] ||
-            !(regex = g_regex_new(pattern, G_REGEX_CASELESS,
-                                  (GRegexMatchFlags)0, nullptr)))
-            continue;
+    Query query = {patterns.ref()};
+    Index<int> matches = query_entries(query);
 
-        for (int i = 0; i < entries; i++)
-        {
-            if (!entry_selected(i))
-                continue;
-
-            Tuple tuple = entry_tuple(i);
-            String string = tuple.get_str(field);
-
-            if (!string ||
-                !g_regex_match(regex, string, (GRegexMatchFlags)0, nullptr))
-                select_entry(i, false);
-        }
+    select_all(false);
 
-        g_regex_unref(regex);
-    }
+    for (int entry : matches)
+        select_entry(entry, true);
 }
 
 static StringBuf make_playlist_path(int playlist)
@@ -281,22 +305,43 @@ static StringBuf make_playlist_path(int playlist)
                            str_printf("playlist_%02d.xspf", 1 + playlist)});
 }
 
-static void load_playlists_real()
+/* A saved playlist, read from disk by the startup thread and inserted into
+ * the playlist list by the main thread. */
+struct SavedPlaylist
+{
+    int stamp;     // -1 for the old naming scheme
+    bool modified;
+    String title;
+    Index<PlaylistAddItem> items;
+
+    SavedPlaylist(int stamp, bool modified) : stamp(stamp), modified(modified)
+    {
+    }
+};
+
+static Index<SavedPlaylist> saved_playlists;
+static std::thread read_thread;
+
+static void read_playlist(const char * path, int stamp, bool modified)
 {
+    auto & saved = saved_playlists.append(stamp, modified);
+    playlist_load(filename_to_uri(path), saved.title, saved.items);
+}
+
+static void read_playlists()
+{
+    int64_t begin = startup_clock();
     const char * folder = aud_get_path(AudPath::PlaylistDir);
 
     /* old (v3.1 and earlier) naming scheme */
 
-    int count;
-    for (count = 0;; count++)
+    for (int count = 0;; count++)
     {
         StringBuf path = make_playlist_path(count);
         if (!g_file_test(path, G_FILE_TEST_EXISTS))
             break;
 
-        PlaylistEx playlist = Playlist::insert_playlist(count);
-        playlist.insert_flat_playlist(filename_to_uri(path));
-        playlist.set_modified(true);
+        read_playlist(path, -1, true);
     }
 
     /* unique ID-based naming scheme */
@@ -306,50 +351,120 @@ static void load_playlists_real()
         order_path, VFSReadOptions(VFS_APPEND_NULL | VFS_IGNORE_MISSING));
     auto order = str_list_to_index(order_string.begin(), " ");
 
-    for (int i = 0; i < order.len(); i++)
+    for (const char * number : order)
     {
-        const char * number = order[i];
-
         StringBuf path =
             filename_build({folder, str_concat({number, ".audpl"})});
         if (!g_file_test(path, G_FILE_TEST_EXISTS))
             path = filename_build({folder, str_concat({number, ".xspf"})});
 
-        PlaylistEx playlist =
-            PlaylistEx::insert_with_stamp(count + i, atoi(number));
-        playlist.insert_flat_playlist(filename_to_uri(path));
-        playlist.set_modified(g_str_has_suffix(path, ".xspf"));
+        read_playlist(path, atoi(number), g_str_has_suffix(path, ".xspf"));
     }
 
+    startup_stage("Read playlists", begin);
+}
+
+static void load_playlists_real()
+{
+    if (read_thread.joinable())
+        read_thread.join();
+    else
+        read_playlists();
+
+    int64_t begin = startup_clock();
+
+    for (int at = 0; at < saved_playlists.len(); at++)
+    {
+        auto & saved = saved_playlists[at];
+        PlaylistEx playlist = (saved.stamp < 0)
+                                  ? Playlist::insert_playlist(at)
+                                  : PlaylistEx::insert_with_stamp(at, saved.stamp);
+
+        if (saved.title)
+            playlist.set_title(saved.title);
+
+        playlist.insert_flat_items(0, std::move(saved.items));
+        playlist.set_modified(saved.modified);
+    }
+
+    saved_playlists.clear();
+
     if (!Playlist::n_playlists())
         Playlist::insert_playlist(0);
+
+    startup_stage("Insert playlists", begin);
 }
 
-static void save_playlists_real()
+/* A batch of playlists to be written by the save thread.  Only modified
+ * playlists carry a snapshot, but all of them are listed, in order. */
+struct SaveBatch
 {
-    int lists = Playlist::n_playlists();
-    const char * folder = aud_get_path(AudPath::PlaylistDir);
+    struct Item
+    {
+        int stamp;
+        bool modified;
+        PlaylistSnapshot snapshot;
+    };
+
+    String folder;
+    Index<Item> items;
+};
 
-    /* save playlists */
+static std::thread save_thread;
+static aud::mutex save_mutex;
+static bool save_busy;
+
+static void write_playlist(const char * folder, const char * number,
+                           const PlaylistSnapshot & snapshot)
+{
+    Index<PlaylistAddItem> items;
+    items.insert(0, snapshot.entries.len());
+
+    for (int i = 0; i < items.len(); i++)
+    {
+        auto & entry = snapshot.entries[i];
+        items[i].filename =
+            String(str_concat({entry.folder, entry.basename}));
+        items[i].tuple = entry.tuple.ref();
+        items[i].tuple.delete_fallbacks();
+    }
+
+    /* write to a temporary file and rename it over the old one, so that an
+     * interrupted save never leaves a truncated playlist behind */
+    StringBuf path = filename_build({folder, str_concat({number, ".audpl"})});
+    StringBuf temp =
+        filename_build({folder, str_concat({number, ".tmp.audpl"})});
+
+    if (!playlist_save(filename_to_uri(temp), snapshot.title, items))
+    {
+        g_unlink(temp);
+        return;
+    }
+
+    if (g_rename(temp, path) < 0)
+    {
+        AUDERR("Failed to rename %s: %s\n", (const char *)temp,
+               strerror(errno));
+        g_unlink(temp);
+    }
+}
+
+static void write_playlists(const SaveBatch & batch)
+{
+    const char * folder = batch.folder;
 
     Index<String> order;
     SimpleHash<String, bool> saved;
 
-    for (int i = 0; i < lists; i++)
+    for (auto & item : batch.items)
     {
-        PlaylistEx playlist = Playlist::by_index(i);
-        StringBuf number = int_to_str(playlist.stamp());
-        StringBuf name = str_concat({number, ".audpl"});
+        StringBuf number = int_to_str(item.stamp);
 
-        if (playlist.get_modified())
-        {
-            StringBuf path = filename_build({folder, name});
-            playlist.save_to_file(filename_to_uri(path), Playlist::NoWait);
-            playlist.set_modified(false);
-        }
+        if (item.modified)
+            write_playlist(folder, number, item.snapshot);
 
         order.append(String(number));
-        saved.add(String(name), true);
+        saved.add(String(str_concat({number, ".audpl"})), true);
     }
 
     StringBuf order_string = index_to_str_list(order, " ");
@@ -383,6 +498,62 @@ static void save_playlists_real()
     g_dir_close(dir);
 }
 
+static void save_worker(SaveBatch batch)
+{
+    write_playlists(batch);
+
+    auto mh = save_mutex.take();
+    save_busy = false;
+}
+
+/* The main thread only takes a snapshot of the modified playlists (which
+ * shares the filenames and tuples rather than copying them); formatting and
+ * writing the files is done in the background, except when exiting. */
+static void save_playlists_real(bool exiting)
+{
+    {
+        auto mh = save_mutex.take();
+
+        /* if the last batch is still being written, try again next time */
+        if (save_busy && !exiting)
+            return;
+    }
+
+    if (save_thread.joinable())
+        save_thread.join();
+
+    SaveBatch batch;
+    batch.folder = String(aud_get_path(AudPath::PlaylistDir));
+
+    int lists = Playlist::n_playlists();
+    batch.items.insert(0, lists);
+
+    for (int i = 0; i < lists; i++)
+    {
+        PlaylistEx playlist = Playlist::by_index(i);
+        auto & item = batch.items[i];
+
+        item.stamp = playlist.stamp();
+        item.modified = playlist.get_modified();
+
+        if (item.modified)
+        {
+            item.snapshot = playlist.snapshot();
+            playlist.set_modified(false);
+        }
+    }
+
+    if (exiting)
+    {
+        write_playlists(batch);
+        return;
+    }
+
+    auto mh = save_mutex.take();
+    save_busy = true;
+    save_thread = std::thread(save_worker, std::move(batch));
+}
+
 static bool hooks_added, state_changed;
 
 static void update_cb(void * data, void *)
@@ -394,6 +565,14 @@ static void update_cb(void * data, void *)
 
 static void state_cb(void * data, void * user) { state_changed = true; }
 
+void load_playlists_start()
+{
+    /* Playlist files are parsed by the playlist plugins, which must be loaded
+     * before this is called.  Parsing doesn't touch the playlist list itself,
+     * so it can proceed while the remaining plugins are started. */
+    read_thread = std::thread(read_playlists);
+}
+
 void load_playlists()
 {
     load_playlists_real();
@@ -413,7 +592,7 @@ void load_playlists()
 
 void save_playlists(bool exiting)
 {
-    save_playlists_real();
+    save_playlists_real(exiting);
 
     /* on exit, save resume states */
     if (state_changed || exiting)
@@ -36,6 +36,7 @@
 #include "multihash.h"
 #include "parse.h"
 #include "playlist-data.h"
+#include "prefetch.h"
 #include "runtime.h"
 #include "threads.h"
 
@@ -64,6 +65,13 @@ enum class UpdateState
 
 #define STATE_FILE "playlist-state"
 
+/* maximum number of scans queued at once by wait_for_entries() */
+#define BULK_SCAN_WINDOW (8 * SCAN_THREADS)
+
+/* entries on either side of the playing entry that are scanned before the rest
+ * of the playlist */
+#define NEARBY_SCAN_ROWS 16
+
 #define ENTER_GET_PLAYLIST(...)                                                \
     auto mh = mutex.take();                                                    \
     PlaylistData * playlist = m_id ? m_id->data : nullptr;                     \
@@ -112,6 +120,7 @@ static Playlist::ID * active_id = nullptr;
 static Playlist::ID * playing_id = nullptr;
 static int resume_playlist = -1;
 static bool resume_paused = false;
+static bool continuing_playback = false;
 
 static QueuedFunc queued_update;
 static Playlist::UpdateLevel update_level;
@@ -168,6 +177,47 @@ static void number_playlists(int at, int length)
         playlists[i]->id()->index = i;
 }
 
+// returns the file that would be opened to play an entry, or nullptr if it is
+// not worth prefetching (e.g. a stream of unknown length)
+static String prefetch_filename(PlaylistData * playlist, int entry_num)
+{
+    Tuple tuple = playlist->entry_tuple(entry_num);
+    if (tuple.get_int(Tuple::Length) <= 0)
+        return String();
+
+    String filename = tuple.get_str(Tuple::AudioFile);
+    if (!filename)
+        filename = playlist->entry_filename(entry_num);
+
+    if (!filename || !strncmp(filename, "stdin://", 8))
+        return String();
+
+    return filename;
+}
+
+static void update_prefetch()
+{
+    int count = aud_get_int("prefetch_tracks");
+    auto playlist = playing_id ? playing_id->data : nullptr;
+
+    if (count <= 0 || !playlist || playlist->position() < 0)
+    {
+        prefetch_set_files(nullptr, Index<String>());
+        return;
+    }
+
+    Index<String> upcoming;
+    for (int entry_num : playlist->upcoming_entries(count))
+    {
+        String filename = prefetch_filename(playlist, entry_num);
+        if (filename && upcoming.find(filename) < 0)
+            upcoming.append(std::move(filename));
+    }
+
+    String current = prefetch_filename(playlist, playlist->position());
+    prefetch_set_files(current, std::move(upcoming));
+}
+
 static void update(void *)
 {
     auto mh = mutex.take();
@@ -186,6 +236,8 @@ static void update(void *)
             position_change_list.append(p->id());
     }
 
+    update_prefetch();
+
     update_hooks = 0;
     update_level = Playlist::NoUpdate;
     update_state = UpdateState::None;
@@ -265,6 +317,18 @@ EXPORT bool Playlist::scan_in_progress() const
     return (playlist->scan_status != PlaylistData::NotScanning);
 }
 
+EXPORT Index<int> Playlist::query_entries(const Query & query) const
+{
+    SIMPLE_WRAPPER(Index<int>, Index<int>(), query_entries, query);
+}
+
+EXPORT Index<Playlist::QueryGroup>
+Playlist::query_totals(const Query & query, Tuple::Field group_by) const
+{
+    SIMPLE_WRAPPER(Index<QueryGroup>, Index<QueryGroup>(), query_totals, query,
+                   group_by);
+}
+
 EXPORT bool Playlist::scan_in_progress_any()
 {
     auto mh = mutex.take();
@@ -285,6 +349,17 @@ static ScanItem * scan_list_find_entry(PlaylistEntry * entry)
     return scan_list.find(match);
 }
 
+/* finds a scan in progress for the same file (possibly in another playlist);
+ * the results of that scan will be shared with <entry> when it completes */
+static ScanItem * scan_list_find_file(PlaylistEntry * entry)
+{
+    auto match = [entry](const ScanItem & item) {
+        return PlaylistData::same_file(item.entry, entry);
+    };
+
+    return scan_list.find(match);
+}
+
 static void scan_queue_entry(PlaylistData * playlist, PlaylistEntry * entry,
                              bool for_playback = false)
 {
@@ -333,11 +408,54 @@ static void scan_check_complete(PlaylistData * playlist)
     event_queue("playlist scan complete", nullptr);
 }
 
+/* queues a scan for the first entry in [at, end) that needs one */
+static bool scan_queue_range(PlaylistData * playlist, int at, int end)
+{
+    if (playlist->scan_status != PlaylistData::ScanActive)
+        return false;
+
+    at = aud::max(at, 0);
+    end = aud::min(end, playlist->n_entries());
+
+    while ((at = playlist->next_unscanned_entry(at, end)) >= 0)
+    {
+        auto entry = playlist->entry_at(at);
+        if (!playlist->fill_from_library(entry, PlaylistData::DelayedUpdate) &&
+            !scan_list_find_file(entry))
+        {
+            scan_queue_entry(playlist, entry);
+            return true;
+        }
+
+        at++;
+    }
+
+    return false;
+}
+
+/* Entries shown by the interface are scanned first, then those around the
+ * playing entry, and then the rest of each playlist in order.  At most
+ * SCAN_THREADS background scans are queued at once, so when the visible range
+ * changes, the new range is serviced as soon as a scan thread is free. */
 static bool scan_queue_next_entry()
 {
     if (!scan_enabled)
         return false;
 
+    for (auto & p : playlists)
+    {
+        if (scan_queue_range(p.get(), p->visible_at,
+                             p->visible_at + p->visible_count))
+            return true;
+    }
+
+    PlaylistData * playing = playing_id ? playing_id->data : nullptr;
+    int pos = playing ? playing->position() : -1;
+
+    if (pos >= 0 && scan_queue_range(playing, pos - NEARBY_SCAN_ROWS,
+                                     pos + NEARBY_SCAN_ROWS + 1))
+        return true;
+
     while (scan_playlist < playlists.len())
     {
         PlaylistData * playlist = playlists[scan_playlist].get();
@@ -351,7 +469,9 @@ static bool scan_queue_next_entry()
                     break;
 
                 auto entry = playlist->entry_at(scan_row);
-                if (!scan_list_find_entry(entry))
+                if (!playlist->fill_from_library(entry,
+                                                 PlaylistData::DelayedUpdate) &&
+                    !scan_list_find_file(entry))
                 {
                     scan_queue_entry(playlist, entry);
                     return true;
@@ -448,22 +568,128 @@ static void wait_for_entry(aud::mutex::holder & mh, PlaylistData * playlist,
         PlaylistEntry * entry = playlist->entry_at(entry_num);
 
         // check whether entry is deleted or has already been scanned
-        if (!entry ||
-            !playlist->entry_needs_rescan(entry, need_decoder, need_tuple))
+        if (!entry)
             return;
 
-        // start scan if not already running ...
-        if (!scan_list_find_entry(entry))
+        playlist->fill_from_library(entry, 0);
+        if (!playlist->entry_needs_rescan(entry, need_decoder, need_tuple))
+            return;
+
+        // start scan if not already running (for this or another entry with
+        // the same file) ...
+        if (!scan_list_find_file(entry))
         {
-            // ... but only once
+            // ... but only once; a scan of another entry does not count, since
+            // it may be canceled or its results not shared with this entry
             if (scan_started)
                 return;
 
             scan_queue_entry(playlist, entry);
+            scan_started = true;
         }
 
         // wait for scan to finish
-        scan_started = true;
+        condvar.wait(mh);
+    }
+}
+
+/* mutex may be unlocked during the call */
+static bool wait_for_entries(aud::mutex::holder & mh, Playlist::ID * id,
+                             int at, int number, bool need_decoder,
+                             bool need_tuple, Playlist::ProgressFunc progress,
+                             void * user)
+{
+    // entries before <ready> have been scanned (or failed), entries before
+    // <next> have had their scans queued; the distance between the two is
+    // limited so that scan_list stays short
+    int ready = at, next = at;
+    int reported = -1;
+
+    // entries between <ready> and <next> whose scans were queued by this call
+    // (as in wait_for_entry, a scan of another entry does not count)
+    Index<PlaylistEntry *> queued;
+
+    while (1)
+    {
+        PlaylistData * playlist = id->data;
+        if (!playlist)
+            return false;
+
+        int entries = playlist->n_entries();
+        int end = (number < 0 || number > entries - at) ? entries : at + number;
+
+        // forget entries that were deleted or moved out of the window
+        queued.remove_if([&](PlaylistEntry * entry) {
+            for (int i = ready; i < aud::min(next, entries); i++)
+            {
+                if (playlist->entry_at(i) == entry)
+                    return false;
+            }
+            return true;
+        });
+
+        while (ready < end)
+        {
+            PlaylistEntry * entry = playlist->entry_at(ready);
+
+            playlist->fill_from_library(entry, 0);
+            int pos = queued.find(entry);
+
+            if (playlist->entry_needs_rescan(entry, need_decoder, need_tuple))
+            {
+                if (ready >= next || scan_list_find_file(entry))
+                    break;
+
+                // start a scan if none has run for this entry yet, but don't
+                // start a second one if it has already run once
+                if (pos < 0)
+                {
+                    scan_queue_entry(playlist, entry);
+                    queued.append(entry);
+                    break;
+                }
+            }
+
+            if (pos >= 0)
+                queued.remove(pos, 1);
+
+            ready++;
+        }
+
+        next = aud::max(next, ready);
+
+        while (next < end && next - ready < BULK_SCAN_WINDOW)
+        {
+            PlaylistEntry * entry = playlist->entry_at(next);
+
+            playlist->fill_from_library(entry, 0);
+            if (playlist->entry_needs_rescan(entry, need_decoder, need_tuple) &&
+                !scan_list_find_file(entry))
+            {
+                scan_queue_entry(playlist, entry);
+                queued.append(entry);
+            }
+
+            next++;
+        }
+
+        if (progress && ready > reported)
+        {
+            reported = ready;
+
+            mh.unlock();
+            bool go_on = progress(ready - at, end - at, user);
+            mh.lock();
+
+            if (!go_on)
+                return false;
+
+            continue; // the playlist may have changed meanwhile
+        }
+
+        if (ready >= end)
+            return true;
+
         condvar.wait(mh);
     }
 }
@@ -484,6 +710,18 @@ static void start_playback_locked(int seek_time, bool pause)
     scan_queue_entry(playlist, entry, true);
 }
 
+static void continue_playback_locked()
+{
+    art_clear_current();
+    scan_reset_playback();
+
+    auto playlist = playing_id->data;
+    int pos = playlist->position();
+
+    playback_set_info(pos, playlist->entry_tuple(pos));
+    playback_continue();
+}
+
 static void stop_playback_locked()
 {
     art_clear_current();
@@ -502,7 +740,13 @@ void pl_signal_position_changed(Playlist::ID * id)
     {
         if (id->data->position() >= 0)
         {
-            start_playback_locked(0, aud_drct_get_paused());
+            // when moving to the next segment of the same file, the playback
+            // thread is already playing the new entry
+            if (continuing_playback)
+                continue_playback_locked();
+            else
+                start_playback_locked(0, aud_drct_get_paused());
+
             queue_update_hooks(PlaybackBegin);
         }
         else
@@ -705,19 +949,21 @@ EXPORT void Playlist::remove_selected() const
 
 EXPORT void Playlist::sort_by_filename(StringCompareFunc compare) const
 {
-    SIMPLE_VOID_WRAPPER(sort, {compare, nullptr});
+    SIMPLE_VOID_WRAPPER(sort, {compare, nullptr, false, Tuple::Invalid});
 }
 EXPORT void Playlist::sort_by_tuple(TupleCompareFunc compare) const
 {
-    SIMPLE_VOID_WRAPPER(sort, {nullptr, compare});
+    SIMPLE_VOID_WRAPPER(sort, {nullptr, compare, false, Tuple::Invalid});
 }
 EXPORT void Playlist::sort_selected_by_filename(StringCompareFunc compare) const
 {
-    SIMPLE_VOID_WRAPPER(sort_selected, {compare, nullptr});
+    SIMPLE_VOID_WRAPPER(sort_selected,
+                        {compare, nullptr, false, Tuple::Invalid});
 }
 EXPORT void Playlist::sort_selected_by_tuple(TupleCompareFunc compare) const
 {
-    SIMPLE_VOID_WRAPPER(sort_selected, {nullptr, compare});
+    SIMPLE_VOID_WRAPPER(sort_selected,
+                        {nullptr, compare, false, Tuple::Invalid});
 }
 EXPORT void Playlist::reverse_order() const
 {
@@ -745,6 +991,21 @@ EXPORT void Playlist::rescan_selected() const
     SIMPLE_VOID_WRAPPER(reset_tuples, true);
 }
 
+EXPORT void Playlist::set_visible_entries(int at, int number) const
+{
+    ENTER_GET_PLAYLIST();
+
+    at = aud::max(at, 0);
+    number = aud::max(number, 0);
+
+    if (at == playlist->visible_at && number == playlist->visible_count)
+        return;
+
+    playlist->visible_at = at;
+    playlist->visible_count = number;
+    scan_schedule();
+}
+
 EXPORT int64_t Playlist::total_length_ms() const
 {
     SIMPLE_WRAPPER(int64_t, 0, total_length);
@@ -970,6 +1231,30 @@ bool PlaylistEx::get_modified() const
     return playlist->modified;
 }
 
+void PlaylistEx::sort_parallel(StringCompareFunc filename_compare,
+                               TupleCompareFunc tuple_compare,
+                               Tuple::Field field, bool selected_only) const
+{
+    ENTER_GET_PLAYLIST();
+
+    PlaylistData::CompareData data = {filename_compare, tuple_compare, true,
+                                      field};
+    if (selected_only)
+        playlist->sort_selected(data);
+    else
+        playlist->sort(data);
+}
+
+PlaylistSnapshot PlaylistEx::snapshot() const
+{
+    PlaylistSnapshot snapshot;
+
+    ENTER_GET_PLAYLIST(snapshot);
+    snapshot.title = playlist->title;
+    playlist->snapshot_entries(snapshot.entries);
+    return snapshot;
+}
+
 EXPORT void Playlist::activate() const
 {
     ENTER_GET_PLAYLIST();
@@ -1098,12 +1383,22 @@ EXPORT Tuple Playlist::entry_tuple(int entry_num, GetMode mode,
     return playlist->entry_tuple(entry_num, error);
 }
 
-EXPORT void Playlist::rescan_file(const char * filename)
+EXPORT bool Playlist::wait_for_entries(int at, int number, bool need_decoder,
+                                       bool need_tuple, ProgressFunc progress,
+                                       void * user) const
 {
     auto mh = mutex.take();
+    if (!m_id || !m_id->data || at < 0)
+        return false;
 
-    for (auto & playlist : playlists)
-        playlist->reset_tuple_of_file(filename);
+    return ::wait_for_entries(mh, m_id, at, number, need_decoder, need_tuple,
+                              progress, user);
+}
+
+EXPORT void Playlist::rescan_file(const char * filename)
+{
+    auto mh = mutex.take();
+    PlaylistData::reset_tuple_of_file(filename);
 }
 
 // called from playback thread
@@ -1149,6 +1444,39 @@ DecodeInfo playback_entry_read(int serial)
     return dec;
 }
 
+// called from playback thread at the end of a segmented track; returns the
+// tuple of the next entry if it is the following segment of the same file
+Tuple playback_entry_next_segment(int serial)
+{
+    auto mh = mutex.take();
+
+    if (!playback_check_serial(serial) ||
+        aud_get_bool("no_playlist_advance") ||
+        aud_get_bool("stop_after_current_song"))
+        return Tuple();
+
+    auto playlist = playing_id->data;
+    int pos = playlist->next_segment_pos();
+
+    return (pos >= 0) ? playlist->entry_tuple(pos) : Tuple();
+}
+
+// called from main thread once the playback thread has moved on to the next
+// segment; returns false if the playlist was changed in the meantime
+bool playback_entry_continue()
+{
+    auto mh = mutex.take();
+
+    if (!playing_id)
+        return false;
+
+    continuing_playback = true;
+    bool moved = playing_id->data->next_segment();
+    continuing_playback = false;
+
+    return moved;
+}
+
 // called from playback thread
 void playback_entry_set_tuple(int serial, Tuple && tuple)
 {
@@ -94,9 +94,25 @@ public:
         Index<String> exts; // supported filename extensions
     };
 
+    /* Metadata query passed to query_entries() and query_totals() */
+    struct Query
+    {
+        Tuple patterns; // string fields: case-insensitive regular expressions
+        Tuple min, max; // integer fields: inclusive bounds (optional)
+    };
+
+    /* Per-value totals returned by query_totals() */
+    struct QueryGroup
+    {
+        String value;   // value of the grouping field (null if not set)
+        int entries;    // number of matching entries
+        int64_t length; // total length in milliseconds
+    };
+
     typedef bool (*FilterFunc)(const char * filename, void * user);
     typedef int (*StringCompareFunc)(const char * a, const char * b);
     typedef int (*TupleCompareFunc)(const Tuple & a, const Tuple & b);
+    typedef bool (*ProgressFunc)(int done, int total, void * user);
 
     /* --- CONSTRUCTOR ETC. --- */
 
@@ -224,6 +240,17 @@ public:
     Tuple entry_tuple(int entry, GetMode mode = Wait,
                       String * error = nullptr) const;
 
+    /* Waits until a range of entries has been scanned, so that subsequent calls
+     * to entry_decoder() and entry_tuple() return without blocking.  Unlike a
+     * series of calls to those functions, all the missing scans are queued
+     * together (ahead of background scanning) and run in parallel.  If given,
+     * <progress> is called (with no lock held) each time more entries become
+     * ready; it may return false to cancel the wait.  Returns false if canceled
+     * or if the playlist was deleted. */
+    bool wait_for_entries(int at, int number, bool need_decoder,
+                          bool need_tuple, ProgressFunc progress = nullptr,
+                          void * user = nullptr) const;
+
     /* Gets/sets the playing or last-played entry (-1 = no entry).
      * Affects playback only if this playlist is currently playing.
      * set_position(get_position()) restarts playback from 0:00.
@@ -320,6 +347,11 @@ public:
     void rescan_all() const;
     void rescan_selected() const;
 
+    /* Tells the background scan which entries are currently shown by the
+     * interface, so that their metadata is read ahead of the rest of the
+     * playlist.  Pass number = 0 when the playlist is no longer shown. */
+    void set_visible_entries(int at, int number) const;
+
     /* Calculates the length in milliseconds of entries in a playlist.  Only
      * takes into account entries for which metadata has already been read. */
     int64_t total_length_ms() const;
@@ -367,6 +399,20 @@ public:
     bool scan_in_progress() const;
     static bool scan_in_progress_any();
 
+    /* Returns the numbers of the entries matching <query>.  The Title, Artist,
+     * Album, AlbumArtist, Genre, and Basename fields can be matched against
+     * patterns, and the Length, Year, Track, and Bitrate fields against
+     * bounds; other fields are ignored.  Queries are evaluated over a
+     * column-oriented copy of the playlist metadata, which is built on first
+     * use and then kept up to date as the playlist changes.  Entries that have
+     * not yet been scanned are matched against their fallback metadata. */
+    Index<int> query_entries(const Query & query) const;
+
+    /* Returns the number and total length of the entries matching <query>,
+     * grouped by <group_by> (one of the string fields listed above). */
+    Index<QueryGroup> query_totals(const Query & query,
+                                   Tuple::Field group_by) const;
+
     /* --- UTILITY API --- */
 
     /* Sorts entries according to a preset scheme. */
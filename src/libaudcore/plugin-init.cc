@@ -191,12 +191,16 @@ static void start_plugins(PluginType type)
     }
 }
 
-void start_plugins_one()
+void start_plugins_zero()
 {
     plugin_system_init();
 
     start_plugins(PluginType::Transport);
     start_plugins(PluginType::Playlist);
+}
+
+void start_plugins_one()
+{
     start_plugins(PluginType::Input);
     start_plugins(PluginType::Effect);
     start_plugins(PluginType::Output);
@@ -36,8 +36,10 @@
 
 /* Increment this when the format of the plugin-registry file changes.
  * Add 10 if the format changes in a way that will break
- * parse_plugins_fallback(). */
-#define FORMAT 11
+ * parse_plugins_fallback().
+ *
+ * Format 12 added the "magic" and "readsubtunes" keys for input plugins. */
+#define FORMAT 12
 
 /* Oldest file format supported by parse_plugins_fallback() */
 #define MIN_FORMAT 2 // "enabled" flag was added in Audacious 2.4
@@ -71,7 +73,8 @@ public:
 
     /* for input plugins */
     aud::array<InputKey, Index<String>> keys;
-    int has_subtunes, writes_tag;
+    int has_subtunes, writes_tag, reads_subtunes;
+    Index<String> magic;
 
     PluginHandle(const char * basename, const char * path, bool loaded,
                  int timestamp, int version, int flags, PluginType type,
@@ -83,7 +86,8 @@ public:
                    type == PluginType::Playlist || type == PluginType::Input)
                       ? PluginEnabled::Primary
                       : PluginEnabled::Disabled),
-          can_save(false), has_subtunes(false), writes_tag(false)
+          can_save(false), has_subtunes(false), writes_tag(false),
+          reads_subtunes(false)
     {
     }
 
@@ -125,6 +129,40 @@ static FILE * open_registry_file(const char * mode)
     return handle;
 }
 
+/* encodes a signature as "offset:pattern[:mask]", in hexadecimal */
+static StringBuf magic_to_string(const InputPlugin::Magic & magic)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    int length = magic.length ? magic.length : strlen(magic.pattern);
+    if (magic.offset < 0 || magic.offset + length > MAGIC_MAX_OFFSET ||
+        length < 1 || length > MAGIC_MAX_LENGTH)
+    {
+        AUDWARN("Invalid file signature at offset %d.\n", magic.offset);
+        return StringBuf();
+    }
+
+    StringBuf str = str_printf("%d", magic.offset);
+
+    for (const char * bytes : {magic.pattern, magic.mask})
+    {
+        if (!bytes)
+            continue;
+
+        int at = str.len();
+        str.resize(at + 1 + 2 * length);
+        str[at] = ':';
+
+        for (int i = 0; i < length; i++)
+        {
+            str[at + 1 + 2 * i] = hex[(unsigned char)bytes[i] >> 4];
+            str[at + 2 + 2 * i] = hex[bytes[i] & 15];
+        }
+    }
+
+    return str;
+}
+
 static void transport_plugin_save(PluginHandle * plugin, FILE * handle)
 {
     for (const String & scheme : plugin->schemes)
@@ -147,8 +185,12 @@ static void input_plugin_save(PluginHandle * plugin, FILE * handle)
             fprintf(handle, "%s %s\n", input_key_names[k], (const char *)key);
     }
 
+    for (const String & magic : plugin->magic)
+        fprintf(handle, "magic %s\n", (const char *)magic);
+
     fprintf(handle, "subtunes %d\n", plugin->has_subtunes);
     fprintf(handle, "writes %d\n", plugin->writes_tag);
+    fprintf(handle, "readsubtunes %d\n", plugin->reads_subtunes);
 }
 
 static void plugin_save(PluginHandle * plugin, FILE * handle)
@@ -255,10 +297,22 @@ static void input_plugin_parse(PluginHandle * plugin, TextParser & parser)
         }
     }
 
+    while (1)
+    {
+        String value = parser.get_str("magic");
+        if (!value)
+            break;
+
+        plugin->magic.append(std::move(value));
+        parser.next();
+    }
+
     if (parser.get_int("subtunes", plugin->has_subtunes))
         parser.next();
     if (parser.get_int("writes", plugin->writes_tag))
         parser.next();
+    if (parser.get_int("readsubtunes", plugin->reads_subtunes))
+        parser.next();
 }
 
 static bool plugin_parse(TextParser & parser)
@@ -514,6 +568,20 @@ static void plugin_get_info(PluginHandle * plugin, bool is_new)
             (ip->input_info.flags & InputPlugin::FlagSubtunes);
         plugin->writes_tag =
             (ip->input_info.flags & InputPlugin::FlagWritesTag);
+        plugin->reads_subtunes =
+            (ip->input_info.flags & InputPlugin::FlagSubtuneTags);
+
+        /* InputInfo::magic was added in version 49 */
+        plugin->magic.clear();
+        if (header->version >= 49 && ip->input_info.magic)
+        {
+            for (auto m = ip->input_info.magic; m->pattern; m++)
+            {
+                StringBuf str = magic_to_string(*m);
+                if (str)
+                    plugin->magic.append(String(str));
+            }
+        }
     }
     else if (header->type == PluginType::Output)
     {
@@ -740,6 +808,16 @@ bool input_plugin_has_subtunes(PluginHandle * plugin)
     return plugin->has_subtunes;
 }
 
+const Index<String> & input_plugin_get_magic(PluginHandle * plugin)
+{
+    return plugin->magic;
+}
+
+bool input_plugin_reads_subtunes(PluginHandle * plugin)
+{
+    return plugin->reads_subtunes;
+}
+
 bool input_plugin_can_write_tuple(PluginHandle * plugin)
 {
     return plugin->writes_tag;
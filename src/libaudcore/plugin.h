@@ -45,10 +45,15 @@ struct PluginPreferences;
  *
  * Before releases that break backward compatibility (e.g. remove pointers from
  * the API tables), increment _AUD_PLUGIN_VERSION *and* set
- * _AUD_PLUGIN_VERSION_MIN to the same value. */
+ * _AUD_PLUGIN_VERSION_MIN to the same value.
+ *
+ * Additions made between two releases share a single increment.  Version 49
+ * adds InputPlugin::read_subtune_tags(), InputInfo::magic (the last member of
+ * InputPlugin), and Visualizer::log_bands and render_log_freq(); the core uses
+ * these only when the corresponding flag or version is set. */
 
 #define _AUD_PLUGIN_VERSION_MIN 48 /* 3.8-devel */
-#define _AUD_PLUGIN_VERSION 48     /* 3.8-devel */
+#define _AUD_PLUGIN_VERSION 49     /* 3.8-devel */
 
 /* Default priority. */
 #define _AUD_PLUGIN_DEFAULT_PRIO 5
@@ -349,7 +354,31 @@ public:
          * to the second song in the file "somefile.sid".
          * 3. When one of the songs is played, Audacious opens the file and
          * calls play() with a file name modified in this way. */
-        FlagSubtunes = (1 << 1)
+        FlagSubtunes = (1 << 1),
+
+        /* Indicates that the plugin implements read_subtune_tags().  Files
+         * containing many songs (game music packs, for example) can then be
+         * expanded and scanned without opening and parsing the file again for
+         * each song. */
+        FlagSubtuneTags = (1 << 2)
+    };
+
+    /* A byte signature identifying a file format: <pattern> found <offset>
+     * bytes from the start of the file.  If <length> is 0, the pattern is a
+     * nul-terminated string.  If <mask> is given, it must be as long as the
+     * pattern and is ANDed with the file data before comparing ("don't care"
+     * bits are 0 in the mask).  Patterns can be at most 64 bytes long and must
+     * lie within the first 64 KiB of the file.  Lists of signatures end with an
+     * entry whose pattern is null.
+     *
+     * Example: {{0, "fLaC"}, {0, "OggS"}, {0, "\xff\xf0", 2, "\xff\xf0"}, {}}
+     */
+    struct Magic
+    {
+        int offset;
+        const char * pattern;
+        int length;
+        const char * mask;
     };
 
     struct InputInfo
@@ -358,9 +387,11 @@ public:
 
         int flags, priority;
         aud::array<InputKey, List> keys;
+        const Magic * magic;
 
         constexpr InputInfo(int flags = 0)
-            : flags(flags), priority(_AUD_PLUGIN_DEFAULT_PRIO), keys{}
+            : flags(flags), priority(_AUD_PLUGIN_DEFAULT_PRIO), keys{},
+              magic(nullptr)
         {
         }
 
@@ -368,14 +399,14 @@ public:
         constexpr InputInfo with_exts(List exts) const
         {
             return InputInfo(flags, priority, exts, keys[InputKey::MIME],
-                             keys[InputKey::Scheme]);
+                             keys[InputKey::Scheme], magic);
         }
 
         /* Associates MIME types with the plugin. */
         constexpr InputInfo with_mimes(List mimes) const
         {
             return InputInfo(flags, priority, keys[InputKey::Ext], mimes,
-                             keys[InputKey::Scheme]);
+                             keys[InputKey::Scheme], magic);
         }
 
         /* Associates custom URI schemes with the plugin.  Plugins using custom
@@ -384,7 +415,7 @@ public:
         constexpr InputInfo with_schemes(List schemes) const
         {
             return InputInfo(flags, priority, keys[InputKey::Ext],
-                             keys[InputKey::MIME], schemes);
+                             keys[InputKey::MIME], schemes, magic);
         }
 
         /* Sets how quickly the plugin should be tried in searching for a plugin
@@ -393,13 +424,28 @@ public:
         constexpr InputInfo with_priority(int priority) const
         {
             return InputInfo(flags, priority, keys[InputKey::Ext],
-                             keys[InputKey::MIME], keys[InputKey::Scheme]);
+                             keys[InputKey::MIME], keys[InputKey::Scheme],
+                             magic);
+        }
+
+        /* Declares byte signatures of the file formats handled by the plugin.
+         * When a file must be identified by its content, the signatures of all
+         * plugins are checked at once, without loading the plugins.  If only
+         * one plugin matches, is_our_file() is not called.  Otherwise, the
+         * plugins that match are asked first, and those whose signatures do
+         * not match are asked last. */
+        constexpr InputInfo with_magic(const Magic * magic) const
+        {
+            return InputInfo(flags, priority, keys[InputKey::Ext],
+                             keys[InputKey::MIME], keys[InputKey::Scheme],
+                             magic);
         }
 
     private:
         constexpr InputInfo(int flags, int priority, List exts, List mimes,
-                            List schemes)
-            : flags(flags), priority(priority), keys{exts, mimes, schemes}
+                            List schemes, const Magic * magic)
+            : flags(flags), priority(priority), keys{exts, mimes, schemes},
+              magic(magic)
         {
         }
     };
@@ -440,6 +486,17 @@ public:
         return false;
     }
 
+    /* Optional.  Reads metadata for several songs of a file with subtunes at
+     * once.  <tuples> contains one tuple per song, with the filename fields
+     * (including the subtune number) already set.  The return value should be
+     * true if all the tuples were successfully read.  Only called if
+     * FlagSubtuneTags is set. */
+    virtual bool read_subtune_tags(const char * filename, VFSFile & file,
+                                   Index<Tuple> & tuples)
+    {
+        return false;
+    }
+
 protected:
     /* Prepares the output system for playback in the specified format.  Also
      * triggers the "playback ready" hook.  Hence, if you call set_replay_gain,
@@ -510,8 +567,9 @@ public:
 class LIBAUDCORE_PUBLIC VisPlugin : public DockablePlugin, public Visualizer
 {
 public:
-    constexpr VisPlugin(PluginInfo info, int type_mask)
-        : DockablePlugin(PluginType::Vis, info), Visualizer(type_mask)
+    constexpr VisPlugin(PluginInfo info, int type_mask, int log_bands = 0)
+        : DockablePlugin(PluginType::Vis, info),
+          Visualizer(type_mask, log_bands)
     {
     }
 };
@@ -34,6 +34,7 @@ enum class PluginEnabled
 };
 
 /* plugin-init.c */
+void start_plugins_zero();
 void start_plugins_one();
 void start_plugins_two();
 void stop_plugins_two();
@@ -66,6 +67,12 @@ bool playlist_plugin_has_ext(PluginHandle * plugin, const char * ext);
 bool input_plugin_has_key(PluginHandle * plugin, InputKey key,
                           const char * value);
 bool input_plugin_has_subtunes(PluginHandle * plugin);
+bool input_plugin_reads_subtunes(PluginHandle * plugin);
+const Index<String> & input_plugin_get_magic(PluginHandle * plugin);
+
+/* limits for file signatures (InputPlugin::Magic) */
+#define MAGIC_MAX_OFFSET 65536
+#define MAGIC_MAX_LENGTH 64
 bool input_plugin_can_write_tuple(PluginHandle * plugin);
 
 #endif
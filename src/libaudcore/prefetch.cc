@@ -0,0 +1,407 @@
+/*
+ * prefetch.cc
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "prefetch.h"
+
+#include <string.h>
+
+#include "internal.h"
+#include "runtime.h"
+#include "threads.h"
+#include "vfs.h"
+
+#define CHUNK_SIZE (1 << 20)
+
+/* immutable once published in the cache; shared with open handles */
+struct PrefetchData
+{
+    String filename;
+    Index<char> data;
+    int64_t file_size; /* -1 if unknown */
+    bool complete;     /* data holds the whole file */
+    int refs;
+};
+
+static aud::mutex mutex;
+static aud::condvar cond;
+static std::thread thread;
+static bool thread_running, quit;
+
+static String current_file;
+static Index<String> wanted_files;
+static Index<String> failed_files; /* not retried until the list changes */
+static Index<PrefetchData *> cache;
+static int serial;            /* incremented when wanted_files changes */
+static String reading_file;   /* being read by the worker thread */
+static bool reading_modified; /* reading_file was modified meanwhile */
+
+static void unref_data(PrefetchData * data)
+{
+    if (!__sync_sub_and_fetch(&data->refs, 1))
+        delete data;
+}
+
+static int find_cached(const char * filename)
+{
+    for (int i = 0; i < cache.len(); i++)
+    {
+        if (!strcmp(cache[i]->filename, filename))
+            return i;
+    }
+
+    return -1;
+}
+
+static bool is_wanted(const char * filename)
+{
+    for (auto & wanted : wanted_files)
+    {
+        if (!strcmp(wanted, filename))
+            return true;
+    }
+
+    return false;
+}
+
+class PrefetchFile : public VFSImpl
+{
+public:
+    PrefetchFile(PrefetchData * data) : m_data(data) {}
+
+    ~PrefetchFile()
+    {
+        delete m_real;
+        unref_data(m_data);
+    }
+
+protected:
+    int64_t fread(void * ptr, int64_t size, int64_t nmemb);
+    int fseek(int64_t offset, VFSSeekType whence);
+
+    int64_t ftell() { return m_pos; }
+    int64_t fsize();
+    bool feof() { return m_eof; }
+
+    int64_t fwrite(const void * ptr, int64_t size, int64_t nmemb) { return 0; }
+    int ftruncate(int64_t length) { return -1; }
+    int fflush() { return 0; }
+
+    String get_metadata(const char * field);
+
+private:
+    PrefetchData * const m_data;
+    VFSImpl * m_real = nullptr; /* opened on demand */
+    int64_t m_pos = 0;
+    bool m_eof = false;
+
+    bool open_real();
+};
+
+/* opens the real file for reads past the cached data (or metadata) */
+bool PrefetchFile::open_real()
+{
+    if (m_real)
+        return true;
+
+    String error;
+    m_real = vfs_transport_open(m_data->filename, "r", error);
+
+    if (!m_real)
+        AUDERR("Cannot open %s: %s.\n", (const char *)m_data->filename,
+               (const char *)error);
+
+    return m_real != nullptr;
+}
+
+int64_t PrefetchFile::fread(void * ptr, int64_t size, int64_t nmemb)
+{
+    if (size <= 0 || nmemb <= 0 || m_eof)
+        return 0;
+
+    int64_t total = size * nmemb;
+    int64_t done = 0;
+
+    if (m_pos < m_data->data.len())
+    {
+        done = aud::min(total, m_data->data.len() - m_pos);
+        memcpy(ptr, &m_data->data[m_pos], done);
+        m_pos += done;
+    }
+
+    if (done < total && !m_data->complete && open_real())
+    {
+        if (m_real->ftell() != m_pos && m_real->fseek(m_pos, VFS_SEEK_SET) < 0)
+            return done / size;
+
+        int64_t read = m_real->fread((char *)ptr + done, 1, total - done);
+        if (read > 0)
+        {
+            done += read;
+            m_pos += read;
+        }
+    }
+
+    if (done < total)
+        m_eof = true;
+
+    return done / size;
+}
+
+int PrefetchFile::fseek(int64_t offset, VFSSeekType whence)
+{
+    int64_t pos;
+
+    switch (whence)
+    {
+    case VFS_SEEK_SET:
+        pos = offset;
+        break;
+    case VFS_SEEK_CUR:
+        pos = m_pos + offset;
+        break;
+    case VFS_SEEK_END:
+        if (fsize() < 0)
+            return -1;
+        pos = fsize() + offset;
+        break;
+    default:
+        return -1;
+    }
+
+    if (pos < 0)
+        return -1;
+
+    m_pos = pos;
+    m_eof = false;
+    return 0;
+}
+
+int64_t PrefetchFile::fsize()
+{
+    return m_data->complete ? m_data->data.len() : m_data->file_size;
+}
+
+String PrefetchFile::get_metadata(const char * field)
+{
+    return open_real() ? m_real->get_metadata(field) : String();
+}
+
+/* reads the beginning of a file; returns nullptr if the file could not be
+ * opened or stopped being wanted meanwhile */
+static PrefetchData * read_file(const char * filename, int64_t limit,
+                                int read_serial)
+{
+    String error;
+    SmartPtr<VFSImpl> file(vfs_transport_open(filename, "r", error));
+    if (!file)
+    {
+        AUDWARN("Cannot prefetch %s: %s.\n", filename, (const char *)error);
+        return nullptr;
+    }
+
+    auto data = new PrefetchData{String(filename), Index<char>(),
+                                 file->fsize(), false, 1};
+
+    while (data->data.len() < limit)
+    {
+        int64_t chunk = aud::min((int64_t)CHUNK_SIZE, limit - data->data.len());
+        data->data.insert(-1, chunk);
+
+        int64_t read = file->fread(data->data.end() - chunk, 1, chunk);
+        data->data.remove(data->data.len() - chunk + aud::max(read, (int64_t)0),
+                          -1);
+
+        if (read < chunk)
+        {
+            if (!file->feof())
+            {
+                AUDWARN("Error prefetching %s.\n", filename);
+                unref_data(data);
+                return nullptr;
+            }
+
+            data->complete = true;
+            break;
+        }
+
+        auto mh = mutex.take();
+        if (quit || reading_modified ||
+            (serial != read_serial && !is_wanted(filename)))
+        {
+            mh.unlock();
+            unref_data(data);
+            return nullptr;
+        }
+    }
+
+    AUDINFO("Prefetched %d bytes of %s\n", data->data.len(), filename);
+    return data;
+}
+
+static void prefetch_worker()
+{
+    auto mh = mutex.take();
+
+    while (!quit)
+    {
+        String next;
+        for (auto & wanted : wanted_files)
+        {
+            if (find_cached(wanted) < 0 && failed_files.find(wanted) < 0)
+            {
+                next = wanted;
+                break;
+            }
+        }
+
+        if (!next)
+        {
+            cond.wait(mh);
+            continue;
+        }
+
+        int read_serial = serial;
+        int64_t limit = (int64_t)aud::clamp(aud_get_int("prefetch_mb"), 1, 1024)
+                        << 20;
+
+        reading_file = next;
+        reading_modified = false;
+
+        mh.unlock();
+        PrefetchData * data = read_file(next, limit, read_serial);
+        mh.lock();
+
+        bool modified = reading_modified;
+        reading_file = String();
+
+        if (data && !quit && !modified && is_wanted(next) &&
+            find_cached(next) < 0)
+            cache.append(data);
+        else
+        {
+            if (data)
+                unref_data(data);
+            if (!quit && (modified || (!data && serial == read_serial)))
+                failed_files.append(next);
+        }
+    }
+}
+
+void prefetch_set_files(const char * current, Index<String> && upcoming)
+{
+    auto mh = mutex.take();
+
+    if (!upcoming.len() && !thread_running)
+        return;
+
+    bool changed = (upcoming.len() != wanted_files.len()) ||
+                   !current_file != !current ||
+                   (current && strcmp(current_file, current));
+
+    for (int i = 0; !changed && i < upcoming.len(); i++)
+        changed = strcmp(upcoming[i], wanted_files[i]);
+
+    if (!changed)
+        return;
+
+    current_file = String(current);
+    wanted_files = std::move(upcoming);
+    failed_files.clear();
+    serial++;
+
+    for (int i = 0; i < cache.len();)
+    {
+        const char * filename = cache[i]->filename;
+
+        if ((current && !strcmp(filename, current)) || is_wanted(filename))
+            i++;
+        else
+        {
+            unref_data(cache[i]);
+            cache.remove(i, 1);
+        }
+    }
+
+    if (!thread_running)
+    {
+        quit = false;
+        thread = std::thread(prefetch_worker);
+        thread_running = true;
+    }
+
+    cond.notify_all();
+}
+
+VFSImpl * prefetch_open(const char * filename)
+{
+    auto mh = mutex.take();
+
+    int i = find_cached(filename);
+    if (i < 0)
+        return nullptr;
+
+    PrefetchData * data = cache[i];
+    __sync_fetch_and_add(&data->refs, 1);
+
+    return new PrefetchFile(data);
+}
+
+void prefetch_invalidate(const char * filename)
+{
+    auto mh = mutex.take();
+
+    int i = find_cached(filename);
+    if (i >= 0)
+    {
+        unref_data(cache[i]);
+        cache.remove(i, 1);
+    }
+
+    if (reading_file && !strcmp(reading_file, filename))
+        reading_modified = true;
+
+    String str(filename);
+    if (is_wanted(filename) && failed_files.find(str) < 0)
+        failed_files.append(std::move(str));
+}
+
+void prefetch_cleanup()
+{
+    auto mh = mutex.take();
+
+    if (thread_running)
+    {
+        quit = true;
+        cond.notify_all();
+
+        mh.unlock();
+        thread.join();
+        mh.lock();
+
+        thread_running = false;
+    }
+
+    for (PrefetchData * data : cache)
+        unref_data(data);
+
+    cache.clear();
+    wanted_files.clear();
+    failed_files.clear();
+    current_file = String();
+}
@@ -0,0 +1,51 @@
+/*
+ * prefetch.h
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef LIBAUDCORE_PREFETCH_H
+#define LIBAUDCORE_PREFETCH_H
+
+/* The prefetch cache reads the beginning (up to "prefetch_mb" megabytes) of
+ * the next few files to be played into memory, so that changing tracks does
+ * not wait for a disk to spin up or a network share to respond.  A read-only
+ * VFSFile opened for a cached file is served from memory, falling back to the
+ * real file for anything past the cached part. */
+
+#include "index.h"
+#include "objects.h"
+
+class VFSImpl;
+
+/* replaces the list of files to be cached (in order of priority); files no
+ * longer in the list are evicted, though open handles keep their data.
+ * <current> is the file now playing; it is kept if already cached (so that
+ * opening it for playback still hits the cache) but is not read otherwise. */
+void prefetch_set_files(const char * current, Index<String> && upcoming);
+
+/* returns a handle reading from the cache, or nullptr if the file is not
+ * (yet) cached */
+VFSImpl * prefetch_open(const char * filename);
+
+/* drops any cached data for a file that is about to be modified (called when
+ * a VFSFile is opened for writing); the file is not read again until the list
+ * of files changes */
+void prefetch_invalidate(const char * filename);
+
+void prefetch_cleanup();
+
+#endif // LIBAUDCORE_PREFETCH_H
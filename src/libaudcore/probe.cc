@@ -28,6 +28,7 @@
 #include "plugin.h"
 #include "plugins-internal.h"
 #include "runtime.h"
+#include "threads.h"
 
 bool open_input_file(const char * filename, const char * mode, InputPlugin * ip,
                      VFSFile & file, String * error)
@@ -56,6 +57,210 @@ InputPlugin * load_input_plugin(PluginHandle * decoder, String * error)
     return ip;
 }
 
+/* The file signatures declared by input plugins (InputPlugin::Magic) are read
+ * from the plugin registry and compiled on first use.  Signatures are grouped
+ * by offset; within a group, those whose first byte must match exactly are
+ * indexed by that byte.  A file header is then checked against every plugin in
+ * a single pass, with only a few comparisons per offset. */
+struct MagicEntry
+{
+    explicit MagicEntry(PluginHandle * plugin) : plugin(plugin) {}
+
+    PluginHandle * plugin;
+    Index<unsigned char> pattern, mask;
+
+    bool matches(const unsigned char * data) const
+    {
+        for (int i = 0; i < pattern.len(); i++)
+        {
+            unsigned char byte = mask.len() ? (data[i] & mask[i]) : data[i];
+            if (byte != pattern[i])
+                return false;
+        }
+
+        return true;
+    }
+};
+
+struct MagicGroup
+{
+    int offset;
+    Index<int> exact[256]; /* entries indexed by first byte */
+    Index<int> masked;     /* entries with a mask on the first byte */
+};
+
+static aud::mutex magic_mutex;
+static bool magic_compiled = false;
+static Index<MagicEntry> magic_entries;
+static Index<MagicGroup> magic_groups;
+static int magic_header_size = 0;
+
+static bool parse_hex(const char * str, int len, Index<unsigned char> & bytes)
+{
+    auto nibble = [](char c) -> int {
+        return (c >= '0' && c <= '9') ? c - '0'
+               : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                                        : -1;
+    };
+
+    if (len < 2 || len % 2 || len > 2 * MAGIC_MAX_LENGTH)
+        return false;
+
+    for (int i = 0; i < len; i += 2)
+    {
+        int hi = nibble(str[i]), lo = nibble(str[i + 1]);
+        if (hi < 0 || lo < 0)
+            return false;
+
+        bytes.append(hi << 4 | lo);
+    }
+
+    return true;
+}
+
+/* parses "offset:pattern[:mask]" as written by the plugin registry */
+static bool parse_magic(const char * str, int & offset, MagicEntry & entry)
+{
+    const char * colon = strchr(str, ':');
+    if (!colon || sscanf(str, "%d", &offset) != 1)
+        return false;
+
+    const char * pattern = colon + 1;
+    const char * mask = strchr(pattern, ':');
+    int pattern_len = mask ? mask - pattern : strlen(pattern);
+
+    if (!parse_hex(pattern, pattern_len, entry.pattern) ||
+        (mask && !parse_hex(mask + 1, strlen(mask + 1), entry.mask)) ||
+        (mask && entry.mask.len() != entry.pattern.len()))
+        return false;
+
+    if (offset < 0 || offset + entry.pattern.len() > MAGIC_MAX_OFFSET)
+        return false;
+
+    /* pre-apply the mask so that matching is a plain comparison */
+    for (int i = 0; i < entry.mask.len(); i++)
+        entry.pattern[i] &= entry.mask[i];
+
+    return true;
+}
+
+static void compile_magic()
+{
+    for (PluginHandle * plugin : aud_plugin_list(PluginType::Input))
+    {
+        for (const String & str : input_plugin_get_magic(plugin))
+        {
+            int offset;
+            MagicEntry entry(plugin);
+
+            if (!parse_magic(str, offset, entry))
+            {
+                AUDWARN("Invalid file signature for %s: %s\n",
+                        aud_plugin_get_name(plugin), (const char *)str);
+                continue;
+            }
+
+            int group = 0;
+            while (group < magic_groups.len() &&
+                   magic_groups[group].offset < offset)
+                group++;
+
+            if (group == magic_groups.len() ||
+                magic_groups[group].offset != offset)
+            {
+                magic_groups.insert(group, 1);
+                magic_groups[group].offset = offset;
+            }
+
+            int index = magic_entries.len();
+            auto & list = (entry.mask.len() && entry.mask[0] != 0xff)
+                              ? magic_groups[group].masked
+                              : magic_groups[group].exact[entry.pattern[0]];
+
+            list.append(index);
+            magic_header_size = aud::max(magic_header_size,
+                                         offset + entry.pattern.len());
+            magic_entries.append(std::move(entry));
+        }
+    }
+
+    AUDINFO("Compiled %d file signatures at %d offsets.\n", magic_entries.len(),
+            magic_groups.len());
+}
+
+/* Orders a list of candidate plugins by checking file signatures.  The plugins
+ * whose signatures match come first, followed by any plugins that have no
+ * signatures.  Plugins none of whose signatures match come last, since a file
+ * may still be in their format (for example, an MP3 file starting with junk);
+ * <n_matched> is set to the number of plugins that matched. */
+static bool filter_by_magic(VFSFile & file,
+                            const Index<PluginHandle *> & candidates,
+                            Index<PluginHandle *> & filtered, int & n_matched)
+{
+    {
+        auto mh = magic_mutex.take();
+        if (!magic_compiled)
+        {
+            compile_magic();
+            magic_compiled = true;
+        }
+    }
+
+    Index<unsigned char> header;
+    Index<PluginHandle *> matches;
+
+    if (magic_header_size)
+    {
+        header.resize(magic_header_size);
+        header.resize(aud::max((int64_t)0,
+                               file.fread(header.begin(), 1, header.len())));
+
+        if (file.fseek(0, VFS_SEEK_SET) != 0)
+            return false;
+    }
+
+    for (auto & group : magic_groups)
+    {
+        if (group.offset >= header.len())
+            break; /* groups are sorted by offset */
+
+        const unsigned char * data = &header[group.offset];
+        int avail = header.len() - group.offset;
+
+        for (auto list : {&group.exact[data[0]], &group.masked})
+        {
+            for (int i : *list)
+            {
+                auto & entry = magic_entries[i];
+                if (entry.pattern.len() <= avail && entry.matches(data) &&
+                    matches.find(entry.plugin) < 0)
+                    matches.append(entry.plugin);
+            }
+        }
+    }
+
+    Index<PluginHandle *> others, unmatched;
+
+    for (PluginHandle * plugin : candidates)
+    {
+        if (!aud_plugin_get_enabled(plugin))
+            continue;
+
+        if (matches.find(plugin) >= 0)
+            filtered.append(plugin);
+        else if (!input_plugin_get_magic(plugin).len())
+            others.append(plugin);
+        else
+            unmatched.append(plugin);
+    }
+
+    n_matched = filtered.len();
+    filtered.insert(others.begin(), -1, others.len());
+    filtered.insert(unmatched.begin(), -1, unmatched.len());
+
+    return true;
+}
+
 /* figure out some basic info without opening the file */
 int probe_by_filename(const char * filename)
 {
@@ -149,11 +354,29 @@ EXPORT PluginHandle * aud_file_find_decoder(const char * filename, bool fast,
 
     file.set_limit_to_buffer(true);
 
-    for (PluginHandle * plugin : (ext_matches.len() ? ext_matches : list))
+    Index<PluginHandle *> to_try;
+    int n_matched = 0;
+
+    if (!filter_by_magic(file, ext_matches.len() ? ext_matches : list, to_try,
+                         n_matched))
     {
-        if (!aud_plugin_get_enabled(plugin))
-            continue;
+        if (error)
+            *error = String(_("Seek error"));
 
+        AUDINFO("Seek failed.\n");
+        return nullptr;
+    }
+
+    /* an unambiguous signature match needs no further checking */
+    if (n_matched == 1)
+    {
+        AUDINFO("Matched %s by signature.\n", aud_plugin_get_name(to_try[0]));
+        file.set_limit_to_buffer(false);
+        return to_try[0];
+    }
+
+    for (PluginHandle * plugin : to_try)
+    {
         AUDINFO("Trying %s.\n", aud_plugin_get_name(plugin));
 
         auto ip = (InputPlugin *)aud_plugin_get_header(plugin);
@@ -212,6 +435,52 @@ EXPORT bool aud_file_read_tag(const char * filename, PluginHandle * decoder,
     return false;
 }
 
+EXPORT Index<PlaylistAddItem>
+aud_file_read_subtune_tags(const char * filename, PluginHandle * decoder,
+                           VFSFile & file, const Tuple & tuple, String * error)
+{
+    Index<PlaylistAddItem> items;
+    Index<Tuple> tuples;
+
+    auto ip = load_input_plugin(decoder, error);
+    if (!ip)
+        return items;
+
+    int n_subtunes = tuple.get_n_subtunes();
+
+    for (int sub = 0; sub < n_subtunes; sub++)
+    {
+        int subtune = tuple.get_nth_subtune(sub);
+        String subname(str_printf("%s?%d", filename, subtune));
+
+        tuples.append();
+        tuples[sub].set_filename(subname);
+        items.append(PlaylistAddItem{subname, Tuple(), decoder});
+    }
+
+    if (!n_subtunes || !open_input_file(filename, "r", ip, file, error))
+        return items;
+
+    if ((ip->input_info.flags & InputPlugin::FlagSubtuneTags) &&
+        ip->read_subtune_tags(filename, file, tuples))
+    {
+        for (int sub = 0; sub < n_subtunes; sub++)
+        {
+            tuples[sub].set_state(Tuple::Valid);
+            items[sub].tuple = std::move(tuples[sub]);
+        }
+    }
+    else
+    {
+        // read the songs one at a time; open_input_file() rewinds the handle
+        for (auto & item : items)
+            aud_file_read_tag(item.filename, decoder, file, item.tuple, nullptr,
+                              error);
+    }
+
+    return items;
+}
+
 EXPORT bool aud_file_can_write_tuple(const char * filename,
                                      PluginHandle * decoder)
 {
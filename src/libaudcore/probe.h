@@ -24,6 +24,7 @@
 #include <libaudcore/objects.h>
 
 class PluginHandle;
+struct PlaylistAddItem;
 class Tuple;
 class VFSFile;
 
@@ -89,6 +90,17 @@ bool aud_file_read_tag(const char * filename, PluginHandle * decoder,
                        VFSFile & file, Tuple & tuple,
                        Index<char> * image = nullptr, String * error = nullptr);
 
+/* Reads metadata for each of the subtunes listed in <tuple>, which should have
+ * been read from the file as a whole by aud_file_read_tag().  Returns one item
+ * per subtune, with the decoder set; any tuple that could not be read is left
+ * invalid.  If the decoder supports it, the songs are read from a single parse
+ * of the file; otherwise, they are read one at a time, re-using <file>. */
+Index<PlaylistAddItem> aud_file_read_subtune_tags(const char * filename,
+                                                  PluginHandle * decoder,
+                                                  VFSFile & file,
+                                                  const Tuple & tuple,
+                                                  String * error = nullptr);
+
 bool aud_file_can_write_tuple(const char * filename, PluginHandle * decoder);
 bool aud_file_write_tuple(const char * filename, PluginHandle * decoder,
                           const Tuple & tuple);
@@ -0,0 +1,581 @@
+/*
+ * render.cc
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "render.h"
+#include "internal.h"
+
+#include <string.h>
+
+#include <glib.h> /* for GThreadPool */
+
+#include "audio.h"
+#include "cue-cache.h"
+#include "hook.h"
+#include "i18n.h"
+#include "output.h"
+#include "plugin.h"
+#include "probe.h"
+#include "runtime.h"
+#include "threads.h"
+#include "tuple.h"
+#include "vfs.h"
+
+/* The input plugin API (open_audio(), write_audio(), etc.) consists of static
+ * functions, which normally talk to the playback thread.  Render threads are
+ * told apart by a thread-local pointer to the job being rendered, and calls
+ * made from them are routed here instead.
+ *
+ * Input plugins are not required to be re-entrant (many keep their decoder
+ * state in globals), so each decoder renders only one file at a time and never
+ * while it is in use for playback.  If playback starts with a decoder that is
+ * rendering, the render is stopped and later restarted from the beginning. */
+
+struct RenderJob
+{
+    RenderJob(int id, const char * filename, const char * dest,
+              const RenderOptions & options)
+        : id(id), filename(filename), dest(dest), options(options)
+    {
+    }
+
+    void run();
+    void fail(const char * message);
+    void open_audio(int format, int rate, int channels);
+    void write_audio(const void * data, int length);
+    void write_header();
+
+    const int id;
+    const String filename, dest;
+    const RenderOptions options;
+
+    // protected by mutex
+    RenderState state = RenderState::Queued;
+    bool cancel = false, discard = false;
+    InputPlugin * decoder = nullptr; /* set while decoding */
+    bool preempted = false;          /* decoder needed for playback */
+    int time = 0, length = -1;
+    String error;
+
+    // used only by the render thread
+    Tuple tuple;
+    ReplayGainInfo gain{};
+    bool gain_valid = false;
+    int time_offset = 0, stop_time = -1;
+    bool seek_pending = false, ended = false;
+
+    VFSFile out;
+    int in_format = -1, out_format = -1;
+    int channels = 0, rate = 0;
+    int64_t frames = 0, data_bytes = 0;
+
+    bool use_eq = false;
+    EqFilter eq;
+    Index<float> buffer;
+    Index<char> out_buffer;
+};
+
+static aud::mutex mutex;
+static aud::condvar decoder_cond;
+static Index<SmartPtr<RenderJob>> jobs;
+static InputPlugin * playback_decoder;
+static int next_id = 1;
+static GThreadPool * pool;
+
+static thread_local RenderJob * current_job;
+
+/* call with mutex locked */
+static int find_job(int id)
+{
+    for (int i = 0; i < jobs.len(); i++)
+    {
+        if (jobs[i]->id == id)
+            return i;
+    }
+
+    return -1;
+}
+
+/* call with mutex locked */
+static bool decoder_in_use(InputPlugin * ip)
+{
+    for (auto & job : jobs)
+    {
+        if (job->decoder == ip)
+            return true;
+    }
+
+    return false;
+}
+
+/* waits until no other job or playback is using <ip>; returns false if the
+ * job was cancelled meanwhile */
+static bool claim_decoder(RenderJob * job, InputPlugin * ip)
+{
+    auto mh = mutex.take();
+
+    while (!job->cancel && (ip == playback_decoder || decoder_in_use(ip)))
+        decoder_cond.wait(mh);
+
+    if (job->cancel)
+        return false;
+
+    job->decoder = ip;
+    return true;
+}
+
+static void release_decoder(RenderJob * job)
+{
+    auto mh = mutex.take();
+    job->decoder = nullptr;
+    decoder_cond.notify_all();
+}
+
+static void put_le16(char * p, int v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void put_le32(char * p, int64_t v)
+{
+    v = aud::min(v, (int64_t)0xffffffff);
+    put_le16(p, v);
+    put_le16(p + 2, v >> 16);
+}
+
+void RenderJob::fail(const char * message)
+{
+    auto mh = mutex.take();
+    if (!error)
+        error = String(message ? message : _("Unknown error"));
+}
+
+void RenderJob::write_header()
+{
+    int sample_size = FMT_SIZEOF(out_format);
+    char header[44];
+
+    memcpy(header, "RIFF", 4);
+    put_le32(header + 4, 36 + data_bytes);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_le32(header + 16, 16);
+    put_le16(header + 20, 1); /* PCM */
+    put_le16(header + 22, channels);
+    put_le32(header + 24, rate);
+    put_le32(header + 28, (int64_t)rate * channels * sample_size);
+    put_le16(header + 32, channels * sample_size);
+    put_le16(header + 34, 8 * sample_size);
+    memcpy(header + 36, "data", 4);
+    put_le32(header + 40, data_bytes);
+
+    if (out.fwrite(header, 1, sizeof header) != sizeof header)
+        fail(_("Error writing output file"));
+}
+
+void RenderJob::open_audio(int format, int new_rate, int new_channels)
+{
+    if (in_format >= 0)
+    {
+        /* the file sink can't change format midstream */
+        if (format != in_format || new_rate != rate || new_channels != channels)
+            fail(_("Audio format changed during rendering"));
+
+        return;
+    }
+
+    if (new_channels < 1 || new_channels > AUD_MAX_CHANNELS || new_rate < 1)
+    {
+        fail(_("Invalid audio format"));
+        return;
+    }
+
+    in_format = format;
+    rate = new_rate;
+    channels = new_channels;
+
+    switch (options.bits)
+    {
+    case 24:
+        out_format = FMT_S24_3LE;
+        break;
+    case 32:
+        out_format = FMT_S32_LE;
+        break;
+    default:
+        out_format = FMT_S16_LE;
+        break;
+    }
+
+    use_eq = options.equalizer && aud_get_bool("equalizer_active");
+    if (use_eq)
+    {
+        eq.set_format(channels, rate);
+        eq.set_bands_from_config();
+    }
+
+    out = VFSFile(dest, "w");
+    if (!out)
+    {
+        fail(out.error());
+        return;
+    }
+
+    /* written again with the correct sizes at the end */
+    write_header();
+
+    seek_pending = (time_offset > 0);
+}
+
+void RenderJob::write_audio(const void * data, int size)
+{
+    if (in_format < 0 || ended)
+        return;
+
+    int samples = size / FMT_SIZEOF(in_format);
+
+    if (stop_time >= 0)
+    {
+        int64_t frames_left =
+            aud::rescale<int64_t>(stop_time, 1000, rate) - frames;
+
+        if (samples >= channels * frames_left)
+        {
+            samples = channels * aud::max((int64_t)0, frames_left);
+            ended = true;
+        }
+    }
+
+    buffer.resize(samples);
+
+    if (in_format == FMT_FLOAT)
+        memcpy(buffer.begin(), data, sizeof(float) * samples);
+    else
+        audio_from_int(data, in_format, buffer.begin(), samples);
+
+    if (options.replay_gain)
+    {
+        float factor = output_replay_gain_factor(gain_valid ? &gain : nullptr);
+        if (factor < 0.99 || factor > 1.01)
+            audio_amplify(buffer.begin(), 1, samples, &factor);
+    }
+
+    if (use_eq)
+        eq.process(buffer.begin(), samples);
+
+    out_buffer.resize(FMT_SIZEOF(out_format) * samples);
+    audio_to_int(buffer.begin(), out_buffer.begin(), out_format, samples);
+
+    if (out.fwrite(out_buffer.begin(), 1, out_buffer.len()) != out_buffer.len())
+    {
+        fail(_("Error writing output file"));
+        return;
+    }
+
+    frames += samples / channels;
+    data_bytes += out_buffer.len();
+
+    auto mh = mutex.take();
+    time = aud::rescale<int64_t>(frames, rate, 1000);
+}
+
+void RenderJob::run()
+{
+    String audio_file = filename;
+    PluginHandle * decoder = nullptr;
+    VFSFile file;
+    String err;
+
+    if (is_cuesheet_entry(filename))
+    {
+        CueCacheRef cue(strip_subtune(filename));
+
+        for (auto & item : cue.load())
+        {
+            if (item.filename == filename)
+            {
+                decoder = item.decoder;
+                tuple = item.tuple.ref();
+                break;
+            }
+        }
+
+        if (tuple.valid())
+            audio_file = tuple.get_str(Tuple::AudioFile);
+    }
+    else if ((decoder = aud_file_find_decoder(filename, false, file, &err)))
+        aud_file_read_tag(filename, decoder, file, tuple, nullptr, &err);
+
+    if (!decoder || !tuple.valid() || !audio_file)
+    {
+        fail(err ? (const char *)err : _("Unknown file type"));
+        return;
+    }
+
+    InputPlugin * ip = load_input_plugin(decoder, &err);
+    if (!ip)
+    {
+        fail(err);
+        return;
+    }
+
+    if (!claim_decoder(this, ip))
+        return;
+
+    if (!open_input_file(audio_file, "r", ip, file, &err))
+    {
+        release_decoder(this);
+        fail(err);
+        return;
+    }
+
+    gain = tuple.get_replay_gain();
+    gain_valid = tuple.has_replay_gain();
+    time_offset = aud::max(0, tuple.get_int(Tuple::StartTime));
+    stop_time =
+        aud::max(-1, tuple.get_int(Tuple::EndTime) - time_offset);
+
+    {
+        auto mh = mutex.take();
+        length = tuple.get_int(Tuple::Length);
+    }
+
+    current_job = this;
+    bool success = ip->play(audio_file, file);
+    current_job = nullptr;
+
+    release_decoder(this);
+
+    {
+        auto mh = mutex.take();
+        if (preempted)
+            return; /* the output is discarded */
+    }
+
+    if (!success)
+        fail(_("Error decoding file"));
+    else if (in_format < 0)
+        fail(_("No audio was decoded"));
+
+    if (out)
+    {
+        if (out.fseek(0, VFS_SEEK_SET) == 0)
+            write_header();
+        if (out.fflush() != 0)
+            fail(_("Error writing output file"));
+    }
+}
+
+static void render_worker(void * data, void *)
+{
+    int id = aud::from_ptr<int>(data);
+    RenderJob * job;
+
+    {
+        auto mh = mutex.take();
+        int i = find_job(id);
+        if (i < 0 || jobs[i]->state != RenderState::Queued)
+            return;
+
+        job = jobs[i].get();
+        job->state = RenderState::Running;
+    }
+
+    // the job is not removed from the list while it is running
+    job->run();
+
+    {
+        auto mh = mutex.take();
+
+        if (job->preempted && !job->cancel)
+        {
+            // start over once the decoder is free again
+            jobs[find_job(id)] = SmartPtr<RenderJob>(new RenderJob(
+                id, job->filename, job->dest, job->options));
+            g_thread_pool_push(pool, aud::to_ptr(id), nullptr);
+            return;
+        }
+
+        if (job->cancel)
+            job->state = RenderState::Cancelled;
+        else if (job->error)
+            job->state = RenderState::Failed;
+        else
+            job->state = RenderState::Finished;
+
+        if (job->error && !job->cancel)
+            AUDERR("Error rendering %s: %s\n", (const char *)job->filename,
+                   (const char *)job->error);
+
+        if (job->discard)
+            jobs.remove(find_job(id), 1);
+    }
+
+    event_queue("render done", aud::to_ptr(id));
+}
+
+EXPORT int aud_render_add(const char * filename, const char * dest,
+                          const RenderOptions & options)
+{
+    auto mh = mutex.take();
+
+    if (!pool)
+        pool = g_thread_pool_new(render_worker, nullptr, g_get_num_processors(),
+                                 false, nullptr);
+
+    int id = next_id++;
+    jobs.append(SmartPtr<RenderJob>(new RenderJob(id, filename, dest, options)));
+    g_thread_pool_push(pool, aud::to_ptr(id), nullptr);
+
+    return id;
+}
+
+EXPORT bool aud_render_get_status(int job, RenderStatus & status)
+{
+    auto mh = mutex.take();
+
+    int i = find_job(job);
+    if (i < 0)
+        return false;
+
+    auto & j = *jobs[i];
+    status = {j.state, j.time, j.length, j.error};
+    return true;
+}
+
+EXPORT void aud_render_cancel(int job)
+{
+    auto mh = mutex.take();
+
+    int i = find_job(job);
+    if (i < 0)
+        return;
+
+    auto & j = *jobs[i];
+    j.cancel = true;
+
+    if (j.state == RenderState::Queued)
+        j.state = RenderState::Cancelled;
+
+    decoder_cond.notify_all();
+}
+
+EXPORT void aud_render_remove(int job)
+{
+    auto mh = mutex.take();
+
+    int i = find_job(job);
+    if (i < 0)
+        return;
+
+    if (jobs[i]->state == RenderState::Running)
+    {
+        jobs[i]->cancel = true;
+        jobs[i]->discard = true;
+        decoder_cond.notify_all();
+    }
+    else
+        jobs.remove(i, 1);
+}
+
+void render_set_playback_decoder(InputPlugin * ip)
+{
+    auto mh = mutex.take();
+
+    playback_decoder = ip;
+
+    for (auto & job : jobs)
+    {
+        if (ip && job->decoder == ip)
+            job->preempted = true;
+    }
+
+    while (ip && decoder_in_use(ip))
+        decoder_cond.wait(mh);
+
+    decoder_cond.notify_all();
+}
+
+bool render_active() { return current_job; }
+
+void render_open_audio(int format, int rate, int channels)
+{
+    current_job->open_audio(format, rate, channels);
+}
+
+void render_set_replay_gain(const ReplayGainInfo & gain)
+{
+    current_job->gain = gain;
+    current_job->gain_valid = true;
+}
+
+void render_write_audio(const void * data, int length)
+{
+    current_job->write_audio(data, length);
+}
+
+Tuple render_get_tuple()
+{
+    Tuple tuple = current_job->tuple.ref();
+    tuple.delete_fallbacks();
+    return tuple;
+}
+
+void render_set_tuple(Tuple && tuple)
+{
+    current_job->tuple = std::move(tuple);
+}
+
+bool render_check_stop()
+{
+    if (current_job->ended)
+        return true;
+
+    auto mh = mutex.take();
+    return current_job->cancel || current_job->error ||
+           current_job->preempted;
+}
+
+int render_check_seek()
+{
+    if (!current_job->seek_pending)
+        return -1;
+
+    // only used to skip to the start of a cuesheet track
+    current_job->seek_pending = false;
+    return current_job->time_offset;
+}
+
+void render_cleanup()
+{
+    {
+        auto mh = mutex.take();
+        for (auto & job : jobs)
+            job->cancel = true;
+
+        decoder_cond.notify_all();
+    }
+
+    if (pool)
+    {
+        g_thread_pool_free(pool, true, true);
+        pool = nullptr;
+    }
+
+    jobs.clear();
+}
@@ -0,0 +1,78 @@
+/*
+ * render.h
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef LIBAUDCORE_RENDER_H
+#define LIBAUDCORE_RENDER_H
+
+#include <libaudcore/objects.h>
+
+/* Offline rendering API.  A render job decodes a song, passes it through the
+ * replay gain and equalizer stages of the output chain, and writes the result
+ * to a WAV file, as fast as the CPU allows rather than in realtime.  Jobs run
+ * in the background, several at once (one per CPU core), independently of
+ * playback.
+ *
+ * Effect plugins are not applied, since they keep state tied to the realtime
+ * output stream.  Equalizer and replay gain settings are taken from the
+ * configuration at the time each job starts.
+ *
+ * When a job ends (for whatever reason), the "render done" hook is called with
+ * the job number (cast to a pointer) as parameter. */
+
+enum class RenderState
+{
+    Queued,
+    Running,
+    Finished,
+    Failed,
+    Cancelled
+};
+
+struct RenderOptions
+{
+    int bits = 16;           // sample size of the WAV file (16, 24, or 32)
+    bool replay_gain = true; // apply replay gain as configured for playback
+    bool equalizer = true;   // apply the equalizer, if it is enabled
+};
+
+struct RenderStatus
+{
+    RenderState state;
+    int time;     // milliseconds rendered so far
+    int length;   // length of the song in milliseconds, or -1 if unknown
+    String error; // set if state is Failed
+};
+
+/* Queues <filename> (a URI) to be rendered to <dest> (also a URI).  Any
+ * existing file at <dest> is overwritten.  Returns a job number, which is
+ * always positive. */
+int aud_render_add(const char * filename, const char * dest,
+                   const RenderOptions & options = RenderOptions());
+
+/* Fills in <status> and returns true, or returns false if there is no such
+ * job.  Finished jobs are remembered until removed. */
+bool aud_render_get_status(int job, RenderStatus & status);
+
+/* Stops a queued or running job.  The partial output file is left as is. */
+void aud_render_cancel(int job);
+
+/* Cancels a job if needed and forgets about it. */
+void aud_render_remove(int job);
+
+#endif // LIBAUDCORE_RENDER_H
@@ -21,6 +21,7 @@
 
 #include <errno.h>
 #include <locale.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -46,7 +47,9 @@
 #include "output.h"
 #include "playlist-internal.h"
 #include "plugins-internal.h"
+#include "prefetch.h"
 #include "scanner.h"
+#include "threads.h"
 
 #define AUTOSAVE_INTERVAL 300000 /* milliseconds, autosave every 5 minutes */
 
@@ -75,9 +78,59 @@ static MainloopType mainloop_type = MainloopType::Qt;
 
 static aud::array<AudPath, String> aud_paths;
 
+struct StartupStage
+{
+    const char * name;
+    int64_t begin, end;
+
+    StartupStage(const char * name, int64_t begin, int64_t end)
+        : name(name), begin(begin), end(end)
+    {
+    }
+};
+
+static bool startup_report;
+static int64_t startup_begin;
+static aud::mutex startup_mutex;
+static Index<StartupStage> startup_stages;
+
 EXPORT void aud_set_headless_mode(bool headless) { headless_mode = headless; }
 EXPORT bool aud_get_headless_mode() { return headless_mode; }
 
+EXPORT void aud_set_startup_report(bool enable) { startup_report = enable; }
+
+int64_t startup_clock() { return g_get_monotonic_time(); }
+
+void startup_stage(const char * name, int64_t begin)
+{
+    if (!startup_report)
+        return;
+
+    auto mh = startup_mutex.take();
+    startup_stages.append(name, begin, g_get_monotonic_time());
+}
+
+static void print_startup_report()
+{
+    auto mh = startup_mutex.take();
+
+    fprintf(stderr, "Startup timing (milliseconds):\n");
+    fprintf(stderr, "  %-20s %8s %8s %8s\n", "Stage", "Start", "End",
+            "Elapsed");
+
+    for (auto & stage : startup_stages)
+        fprintf(stderr, "  %-20s %8.1f %8.1f %8.1f\n", stage.name,
+                (stage.begin - startup_begin) / 1000.0,
+                (stage.end - startup_begin) / 1000.0,
+                (stage.end - stage.begin) / 1000.0);
+
+    fprintf(stderr, "  Interface started after %.1f ms.\n",
+            (g_get_monotonic_time() - startup_begin) / 1000.0);
+
+    startup_stages.clear();
+    startup_report = false;
+}
+
 EXPORT void aud_set_instance(int instance) { instance_number = instance; }
 EXPORT int aud_get_instance() { return instance_number; }
 
@@ -281,16 +334,34 @@ EXPORT void aud_init_i18n()
 
 EXPORT void aud_init()
 {
+    startup_begin = startup_clock();
+
     g_thread_pool_set_max_idle_time(100);
 
+    int64_t begin = startup_clock();
     config_load();
+    startup_stage("Load config", begin);
 
+    begin = startup_clock();
     chardet_init();
     eq_init();
     output_init();
+    vis_runner_init();
     playlist_init();
+    startup_stage("Init core", begin);
+
+    begin = startup_clock();
+    start_plugins_zero();
+    startup_stage("Scan plugins", begin);
 
+    /* the saved playlists are read in a separate thread while the input,
+     * effect, and output plugins start (opening the audio device in
+     * particular can take a while) */
+    load_playlists_start();
+
+    begin = startup_clock();
     start_plugins_one();
+    startup_stage("Start plugins", begin);
 
     record_init();
     scanner_init();
@@ -312,7 +383,13 @@ EXPORT void aud_run()
      * it can be scanned more efficiently (album art read in the same pass). */
     playlist_enable_scan(true);
     playlist_clear_updates();
+
+    int64_t begin = startup_clock();
     start_plugins_two();
+    startup_stage("Start interface", begin);
+
+    if (startup_report)
+        print_startup_report();
 
     static QueuedFunc autosave;
     autosave.start(AUTOSAVE_INTERVAL, do_autosave, nullptr);
@@ -334,14 +411,18 @@ EXPORT void aud_cleanup()
     playback_stop(true);
 
     adder_cleanup();
+    render_cleanup();
     scanner_cleanup();
+    prefetch_cleanup();
     record_cleanup();
 
     stop_plugins_one();
 
     art_cleanup();
+    art_search_cleanup();
     chardet_cleanup();
     eq_cleanup();
+    vis_runner_cleanup();
     output_cleanup();
     playlist_end();
 
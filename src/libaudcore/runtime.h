@@ -123,6 +123,15 @@ const char * aud_get_path(AudPath id);
 void aud_set_headless_mode(bool headless);
 bool aud_get_headless_mode();
 
+// Prints the time taken by each stage of startup to stderr, once the interface
+// has been started.  Must be called before aud_init().
+void aud_set_startup_report(bool enable);
+
+// Returns a table of lock acquisitions, wait and hold times for each call site
+// of aud::mutex::take() etc., busiest first, optionally resetting the counts.
+// Returns null unless Audacious was configured with --enable-lock-profile.
+String aud_lock_profile_report(bool reset = false);
+
 // Note that the UserDir and PlaylistDir paths vary depending on the instance
 // number.  Therefore, calling aud_set_instance() after these paths have been
 // referenced, or after aud_init(), is an error.
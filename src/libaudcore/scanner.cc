@@ -25,8 +25,10 @@
 #include "cue-cache.h"
 #include "i18n.h"
 #include "internal.h"
+#include "plugins-internal.h"
 #include "plugins.h"
 #include "probe.h"
+#include "subtune-cache.h"
 #include "tuple.h"
 #include "vfs.h"
 
@@ -44,6 +46,12 @@ ScanRequest::ScanRequest(const String & filename, int flags, Callback callback,
      * as consecutive playlist entries reference it. */
     if (!this->tuple.valid() && is_cuesheet_entry(filename))
         cue_cache.capture(new CueCacheRef(strip_subtune(filename)));
+    /* Likewise, all the subtunes of a file are read at once if the decoder
+     * supports it. */
+    else if (!this->tuple.valid() && (flags & SCAN_TUPLE) && decoder &&
+             is_subtune(filename) && input_plugin_reads_subtunes(decoder))
+        subtune_cache.capture(
+            new SubtuneCacheRef(strip_subtune(filename), decoder));
 }
 
 void ScanRequest::read_cuesheet_entry()
@@ -59,11 +67,26 @@ void ScanRequest::read_cuesheet_entry()
     }
 }
 
+void ScanRequest::read_subtune()
+{
+    for (auto & item : subtune_cache->load())
+    {
+        if (item.filename == filename)
+        {
+            tuple = item.tuple.ref();
+            break;
+        }
+    }
+}
+
 void ScanRequest::run()
 {
     /* load cuesheet entry (possibly cached) */
     if (cue_cache)
         read_cuesheet_entry();
+    /* likewise for a subtune (falls back to reading it alone on failure) */
+    else if (subtune_cache)
+        read_subtune();
 
     /* for a cuesheet entry, determine the source filename */
     String audio_file = tuple.get_str(Tuple::AudioFile);
@@ -23,6 +23,7 @@
 #include "cue-cache.h"
 #include "index.h"
 #include "objects.h"
+#include "subtune-cache.h"
 #include "tuple.h"
 #include "vfs.h"
 
@@ -60,8 +61,10 @@ struct ScanRequest
 
 private:
     SmartPtr<CueCacheRef> cue_cache;
+    SmartPtr<SubtuneCacheRef> subtune_cache;
 
     void read_cuesheet_entry();
+    void read_subtune();
 };
 
 void scanner_init();
@@ -36,10 +36,14 @@
 #endif
 #endif
 
+/* Strings are normally allocated from a per-thread stack.  A string that
+ * doesn't fit in the remaining space is "spilled" to the heap instead, and
+ * stays there until it is freed. */
 struct StringHeader
 {
-    StringHeader *next, *prev;
+    StringHeader *next, *prev; // unused for heap strings
     int len;
+    int heap_size; // allocated size if on the heap, otherwise 0
 };
 
 struct StringStack
@@ -50,6 +54,20 @@ struct StringStack
     char buf[Size - sizeof top];
 };
 
+/* Stacks of exited threads are kept for reuse (vfs_async and the GLib thread
+ * pools start and stop threads frequently).  The stack memory is only
+ * reserved when mapped; pages are committed by the system as they are first
+ * touched, and all but the first few are released again when a stack is
+ * returned to the pool, so that memory use follows the strings actually in
+ * use rather than the number of threads that have existed. */
+static constexpr int POOL_SIZE = 16;
+static constexpr int MAX_STACK_STRING = StringStack::Size / 4;
+static constexpr int KEEP_RESIDENT = 65536;
+
+static StringStack * pool[POOL_SIZE];
+static int pool_count;
+static aud::mutex pool_mutex;
+
 static constexpr intptr_t align(intptr_t ptr, intptr_t size)
 {
     return (ptr + (size - 1)) / size * size;
@@ -75,16 +93,40 @@ static std::once_flag once;
 static HANDLE mapping;
 #endif
 
-static void free_stack(void * stack)
+static void unmap_stack(StringStack * stack)
 {
-    if (stack)
 #ifdef _WIN32
-        UnmapViewOfFile(stack);
+    UnmapViewOfFile(stack);
 #else
-        munmap(stack, sizeof(StringStack));
+    munmap(stack, sizeof(StringStack));
 #endif
 }
 
+static void free_stack(void * data)
+{
+    auto stack = (StringStack *)data;
+    if (!stack)
+        return;
+
+    auto mh = pool_mutex.take();
+
+    if (pool_count == POOL_SIZE)
+    {
+        mh.unlock();
+        unmap_stack(stack);
+        return;
+    }
+
+    stack->top = nullptr;
+
+#if !defined(_WIN32) && defined(MADV_DONTNEED)
+    madvise((char *)stack + KEEP_RESIDENT, sizeof(StringStack) - KEEP_RESIDENT,
+            MADV_DONTNEED);
+#endif
+
+    pool[pool_count++] = stack;
+}
+
 static void make_key()
 {
     pthread_key_create(&key, free_stack);
@@ -98,36 +140,74 @@ static void make_key()
 #endif
 }
 
-static StringStack * get_stack()
+static StringStack * new_stack()
 {
-    std::call_once(once, make_key);
-
-    StringStack * stack = (StringStack *)pthread_getspecific(key);
-
-    if (!stack)
     {
+        auto mh = pool_mutex.take();
+        if (pool_count)
+            return pool[--pool_count];
+    }
+
 #ifdef _WIN32
-        stack = (StringStack *)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0,
-                                             sizeof(StringStack));
+    auto stack = (StringStack *)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0,
+                                              sizeof(StringStack));
 
-        if (!stack)
-            throw std::bad_alloc();
+    if (!stack)
+        throw std::bad_alloc();
 #else
-        stack = (StringStack *)mmap(nullptr, sizeof(StringStack),
-                                    PROT_READ | PROT_WRITE,
-                                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    auto stack = (StringStack *)mmap(nullptr, sizeof(StringStack),
+                                     PROT_READ | PROT_WRITE,
+                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
 
-        if (stack == MAP_FAILED)
-            throw std::bad_alloc();
+    if (stack == MAP_FAILED)
+        throw std::bad_alloc();
 #endif
 
-        stack->top = nullptr;
+    stack->top = nullptr;
+    return stack;
+}
+
+static StringStack * get_stack()
+{
+    std::call_once(once, make_key);
+
+    StringStack * stack = (StringStack *)pthread_getspecific(key);
+
+    if (!stack)
+    {
+        stack = new_stack();
         pthread_setspecific(key, stack);
     }
 
     return stack;
 }
 
+/* removes a string from the stack (but does not free a heap string) */
+static void unlink_header(StringStack * stack, StringHeader * header)
+{
+    if (header->heap_size)
+        return;
+
+    if (header->prev)
+        header->prev->next = header->next;
+
+    if (header == stack->top)
+        stack->top = header->prev;
+    else
+        header->next->prev = header->prev;
+}
+
+static StringHeader * alloc_heap(StringHeader * header, int size)
+{
+    header = (StringHeader *)realloc(header, sizeof(StringHeader) + size);
+    if (!header)
+        throw std::bad_alloc();
+
+    header->next = header->prev = nullptr;
+    header->heap_size = size;
+    return header;
+}
+
 EXPORT void StringBuf::resize(int len)
 {
     if (!stack)
@@ -140,39 +220,69 @@ EXPORT void StringBuf::resize(int len)
     {
         header = (StringHeader *)(m_data - sizeof(StringHeader));
 
-        /* check if there is enough space in the current location */
-        char * limit = header->next ? (char *)header->next
-                                    : (char *)stack + sizeof(StringStack);
-        int max_len = limit - 1 - m_data;
-
-        if ((len < 0 && !header->next) || (len >= 0 && len < max_len))
+        if (header->heap_size)
         {
-            m_len = header->len = (len < 0) ? max_len : len;
+            /* a heap string asked to be "as large as possible" doubles */
+            int new_len = (len < 0) ? aud::max(2 * m_len, 4096) : len;
+
+            if (new_len >= header->heap_size)
+            {
+                int size = aud::max(new_len + 1, header->heap_size * 3 / 2);
+                header = alloc_heap(header, size);
+                m_data = (char *)header + sizeof(StringHeader);
+            }
+
+            m_len = header->len = new_len;
             need_alloc = false;
         }
+        else
+        {
+            /* check if there is enough space in the current location */
+            char * limit = header->next ? (char *)header->next
+                                        : (char *)stack + sizeof(StringStack);
+            int max_len = limit - 1 - m_data;
+
+            if ((len < 0 && !header->next) ||
+                (len >= 0 && len < max_len && len <= MAX_STACK_STRING))
+            {
+                m_len = header->len = (len < 0) ? max_len : len;
+                need_alloc = false;
+            }
+        }
     }
 
     if (need_alloc)
     {
-        /* allocate a new string at the top of the stack */
+        /* allocate a new string at the top of the stack, if it fits */
         StringHeader * new_header = align_after(stack, stack->top);
         char * new_data = (char *)new_header + sizeof(StringHeader);
         char * limit = (char *)stack + sizeof(StringStack);
         int max_len = limit - 1 - new_data;
+        int min_len = (len < 0) ? m_len : len;
+        int new_len;
 
-        if (max_len < aud::max(len, 0))
-            throw std::bad_alloc();
+        if (max_len >= min_len && min_len <= MAX_STACK_STRING)
+        {
+            new_len = (len < 0) ? max_len : len;
 
-        int new_len = (len < 0) ? max_len : len;
+            if (stack->top)
+                stack->top->next = new_header;
 
-        if (stack->top)
-            stack->top->next = new_header;
+            new_header->prev = stack->top;
+            new_header->next = nullptr;
+            new_header->heap_size = 0;
 
-        new_header->prev = stack->top;
-        new_header->next = nullptr;
-        new_header->len = new_len;
+            stack->top = new_header;
+        }
+        else
+        {
+            /* otherwise spill it to the heap */
+            new_len = (len < 0) ? aud::max(2 * m_len, 4096) : len;
+            new_header = alloc_heap(nullptr, aud::max(new_len + 1, 4096));
+            new_data = (char *)new_header + sizeof(StringHeader);
+        }
 
-        stack->top = new_header;
+        new_header->len = new_len;
 
         /* move the old data, if any */
         if (m_data)
@@ -180,11 +290,7 @@ EXPORT void StringBuf::resize(int len)
             int bytes_to_copy = aud::min(m_len, new_len);
             memcpy(new_data, m_data, bytes_to_copy);
 
-            if (header->prev)
-                header->prev->next = header->next;
-
-            /* we know header != stack->top */
-            header->next->prev = header->prev;
+            unlink_header(stack, header);
         }
 
         m_data = new_data;
@@ -192,7 +298,7 @@ EXPORT void StringBuf::resize(int len)
     }
 
     /* Null-terminate the string except when the maximum length was requested
-     * (to avoid paging in the entire 1 MB stack prematurely).  The caller is
+     * (to avoid paging in the rest of the stack prematurely).  The caller is
      * expected to follow up with a more realistic resize() in this case. */
     if (len >= 0)
         m_data[len] = 0;
@@ -204,13 +310,10 @@ EXPORT StringBuf::~StringBuf()
     {
         auto header = (StringHeader *)(m_data - sizeof(StringHeader));
 
-        if (header->prev)
-            header->prev->next = header->next;
-
-        if (header == stack->top)
-            stack->top = header->prev;
+        if (header->heap_size)
+            free(header);
         else
-            header->next->prev = header->prev;
+            unlink_header(stack, header);
     }
 }
 
@@ -225,6 +328,9 @@ EXPORT StringBuf && StringBuf::settle()
     {
         /* collapse any space preceding this string */
         auto header = (StringHeader *)(m_data - sizeof(StringHeader));
+        if (header->heap_size)
+            return std::move(*this);
+
         StringHeader * new_header = align_after(stack, header->prev);
 
         if (new_header != header)
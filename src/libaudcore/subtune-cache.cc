@@ -0,0 +1,37 @@
+/*
+ * subtune-cache.cc
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "subtune-cache.h"
+#include "probe.h"
+#include "vfs.h"
+
+static ItemCache cache;
+
+SubtuneCacheRef::SubtuneCacheRef(const char * filename, PluginHandle * decoder)
+    : ItemCacheRef(cache, filename), m_decoder(decoder)
+{
+}
+
+void SubtuneCacheRef::load_items(Index<PlaylistAddItem> & items)
+{
+    VFSFile file;
+    Tuple tuple;
+    if (aud_file_read_tag(m_filename, m_decoder, file, tuple))
+        items = aud_file_read_subtune_tags(m_filename, m_decoder, file, tuple);
+}
@@ -0,0 +1,40 @@
+/*
+ * subtune-cache.h
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef LIBAUDCORE_SUBTUNE_CACHE_H
+#define LIBAUDCORE_SUBTUNE_CACHE_H
+
+#include "item-cache.h"
+
+/* Shares the metadata of all the subtunes of a file between scan requests, so
+ * that the file is opened and parsed only once.  Used only with decoders that
+ * can read all the subtunes at once (InputPlugin::FlagSubtuneTags). */
+class SubtuneCacheRef : public ItemCacheRef
+{
+public:
+    SubtuneCacheRef(const char * filename, PluginHandle * decoder);
+
+protected:
+    void load_items(Index<PlaylistAddItem> & items);
+
+private:
+    PluginHandle * const m_decoder;
+};
+
+#endif // LIBAUDCORE_SUBTUNE_CACHE_H
@@ -20,12 +20,16 @@
 #include "audio.h"
 #include "audstrings.h"
 #include "internal.h"
+#include "playlist-columns.h"
 #include "ringbuf.h"
 #include "tuple.h"
 #include "tuple-compiler.h"
 #include "vfs.h"
+#include "visualizer.h"
 
 #include <assert.h>
+#include <limits.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -322,6 +326,98 @@ static void test_tuple_formats ()
     test_tuple_format ("x${(empty)?\"Literal\":Empty}", tuple, "Song Title");
 }
 
+static void test_tuple_album ()
+{
+    Tuple a, b;
+
+    for (Tuple * t : {& a, & b})
+    {
+        t->set_str (Tuple::Album, "Album");
+        t->set_str (Tuple::Genre, "Genre");
+        t->set_int (Tuple::Year, 1990);
+    }
+
+    a.set_str (Tuple::Title, "One");
+    b.set_str (Tuple::Title, "Two");
+    a.set_state (Tuple::Valid);
+    b.set_state (Tuple::Valid);
+
+    assert (a.same_album (b));
+    assert (a != b);
+
+    /* per-track override must not leak into the shared album block */
+    Tuple c = b.ref ();
+    c.set_str (Tuple::Genre, "Other");
+    assert (! strcmp (b.get_str (Tuple::Genre), "Genre"));
+    assert (! strcmp (c.get_str (Tuple::Genre), "Other"));
+    assert (c.get_int (Tuple::Year) == 1990);
+    assert (a.same_album (c));
+
+    c.unset (Tuple::Genre);
+    assert (! c.is_set (Tuple::Genre));
+    assert (b.get_int (Tuple::Year) == 1990);
+
+    c.unset (Tuple::Album);
+    assert (! a.same_album (c));
+    assert (! strcmp (b.get_str (Tuple::Album), "Album"));
+
+    c.set_str (Tuple::Title, "Two");
+    c.set_str (Tuple::Album, "Album");
+    c.set_str (Tuple::Genre, "Genre");
+    c.set_state (Tuple::Valid);
+    assert (b == c);
+
+    assert (! Tuple ().same_album (Tuple ()));
+}
+
+static void test_playlist_columns ()
+{
+    static const char * const artists[] = {"A", "B", nullptr};
+
+    PlaylistColumns columns;
+    columns.resize (100);
+
+    for (int i = 0; i < 100; i ++)
+    {
+        Tuple tuple;
+        tuple.set_str (Tuple::Artist, artists[i % 3]);
+        tuple.set_int (Tuple::Length, i * 1000);
+        columns.set_row (i, tuple);
+    }
+
+    int artist = PlaylistColumns::str_column (Tuple::Artist);
+    int length = PlaylistColumns::int_column (Tuple::Length);
+    assert (artist >= 0 && length >= 0);
+    assert (PlaylistColumns::int_column (Tuple::Title) < 0);
+
+    RowSet all (100, true);
+    assert (all.count () == 100);
+    assert (columns.sum_int (length, all) == 4950 * 1000);
+
+    int calls = 0;
+    RowSet rows (100, true);
+    columns.filter_str (artist, rows, [& calls] (const char * value) {
+        calls ++;
+        return ! strcmp (value, "B");
+    });
+
+    assert (calls == 2); /* once per distinct value */
+    assert (rows.count () == 33);
+    assert (rows.get (1) && ! rows.get (0) && ! rows.get (2));
+
+    columns.filter_int (length, 50000, 70000, rows);
+    assert (rows.count () == 7); /* 52, 55, ..., 70 */
+
+    int sum = 0;
+    rows.iterate ([& sum] (int row) { sum += row; });
+    assert (sum == 52 + 55 + 58 + 61 + 64 + 67 + 70);
+
+    columns.resize (10);
+    RowSet few (10, true);
+    columns.filter_int (length, 5000, INT_MAX, few);
+    assert (few.count () == 5);
+}
+
 static void test_ringbuf ()
 {
     String nums[10];
@@ -498,6 +594,22 @@ static void test_stringbuf ()
     expect[262144] = 0;
 
     assert (! strcmp (str1, expect));
+
+    /* strings too large for the stack are moved to the heap */
+    StringBuf big (3 * 1048576);
+    memset (big, 'x', big.len ());
+    StringBuf small = str_copy ("ab");
+    big.insert (0, "y", 1);
+
+    assert (big.len () == 3 * 1048576 + 1 && big[0] == 'y' && big[1] == 'x');
+    assert (! strcmp (small, "ab"));
+
+    StringBuf printed = str_printf ("%s%s", (const char *) big, (const char *) big);
+    assert (printed.len () == 2 * big.len ());
+    assert (! strncmp (printed + big.len (), "yxx", 3));
+
+    str_append_printf (printed, "%d", 42);
+    assert (! strcmp (printed + 2 * big.len (), "42"));
 }
 
 static void test_str_printf ()
@@ -516,6 +628,336 @@ static void test_str_printf ()
     assert (! strcmp (problem, "6 * 7 = 42"));
 }
 
+/* reference versions of the string kernels in audstrings.cc */
+
+static unsigned ref_calc_hash (const char * s)
+{
+    unsigned h = 5381;
+    for (; * s; s ++)
+        h = h * 33 + * s;
+
+    return h;
+}
+
+static int ref_cmp_nocase (const char * a, const char * b, int len)
+{
+    for (; len; a ++, b ++, len --)
+    {
+        int ca = (* a >= 'A' && * a <= 'Z') ? * a + 32 : (unsigned char) * a;
+        int cb = (* b >= 'A' && * b <= 'Z') ? * b + 32 : (unsigned char) * b;
+
+        if (ca != cb || ! ca)
+            return ca - cb;
+    }
+
+    return 0;
+}
+
+static const char * ref_strstr_nocase (const char * haystack, const char * needle)
+{
+    for (; ; haystack ++)
+    {
+        int len = strlen (needle);
+        if (! ref_cmp_nocase (haystack, needle, len))
+            return haystack;
+        if (! * haystack)
+            return nullptr;
+    }
+}
+
+static int ref_str_compare (const char * ap, const char * bp)
+{
+    unsigned char a = * ap ++, b = * bp ++;
+    for (; a || b; a = * ap ++, b = * bp ++)
+    {
+        if (a > '9' || b > '9' || a < '0' || b < '0')
+        {
+            if (a <= 'Z' && a >= 'A')
+                a += 'a' - 'A';
+            if (b <= 'Z' && b >= 'A')
+                b += 'a' - 'A';
+
+            if (a != b)
+                return (a > b) ? 1 : -1;
+        }
+        else
+        {
+            int x = a - '0';
+            for (; (a = * ap) <= '9' && a >= '0'; ap ++)
+                x = 10 * x + (a - '0');
+
+            int y = b - '0';
+            for (; (b = * bp) >= '0' && b <= '9'; bp ++)
+                y = 10 * y + (b - '0');
+
+            if (x != y)
+                return (x > y) ? 1 : -1;
+        }
+    }
+
+    return 0;
+}
+
+static int sign (int x)
+{
+    return (x > 0) - (x < 0);
+}
+
+static void check_string_pair (const char * a, const char * b)
+{
+    assert (sign (strcmp_nocase (a, b)) == sign (ref_cmp_nocase (a, b, -1)));
+
+    for (int len = 0; len < 12; len ++)
+        assert (sign (strcmp_nocase (a, b, len)) == sign (ref_cmp_nocase (a, b, len)));
+
+    assert (strstr_nocase (a, b) == ref_strstr_nocase (a, b));
+    assert (sign (str_compare (a, b)) == ref_str_compare (a, b));
+}
+
+static void test_string_kernels ()
+{
+    /* exhaustive over short strings made of letters, digits, and the
+     * characters next to 'A'-'Z' and 'a'-'z' in the ASCII table */
+    static const char chars[] = "aAzZ@[`{09\xe9";
+    const int n_chars = sizeof chars - 1;
+
+    Index<String> strings;
+    strings.append (String (""));
+
+    for (int i = 0; i < strings.len (); i ++)
+    {
+        if (strlen (strings[i]) == 3)
+            continue;
+
+        for (int c = 0; c < n_chars; c ++)
+            strings.append (String (str_concat ({strings[i], str_copy (& chars[c], 1)})));
+    }
+
+    for (const String & a : strings)
+    {
+        assert (str_calc_hash (a) == ref_calc_hash (a));
+
+        for (const String & b : strings)
+            check_string_pair (a, b);
+    }
+
+    /* longer strings at every alignment, to exercise the word loops */
+    char buf1[96], buf2[96];
+    unsigned seed = 1;
+
+    for (int iter = 0; iter < 2000; iter ++)
+    {
+        int len = iter % 40;
+        int off1 = iter % 8, off2 = (iter / 8) % 8;
+
+        for (int i = 0; i < len; i ++)
+        {
+            seed = seed * 1103515245 + 12345;
+            buf1[off1 + i] = buf2[off2 + i] = chars[(seed >> 16) % n_chars];
+        }
+
+        buf1[off1 + len] = buf2[off2 + len] = 0;
+
+        const char * a = buf1 + off1;
+        char * b = buf2 + off2;
+
+        assert (str_calc_hash (a) == ref_calc_hash (a));
+        check_string_pair (a, b);
+
+        if (len)
+        {
+            /* change case, then content, at a random position */
+            int pos = (seed >> 8) % len;
+            b[pos] ^= 0x20;
+            check_string_pair (a, b);
+            b[pos] = '5';
+            check_string_pair (a, b);
+            check_string_pair (a, b + pos);
+            check_string_pair (a + pos / 2, b + pos / 2);
+        }
+    }
+
+    /* numbers must not be split by the common prefix */
+    assert (str_compare ("a105", "a19") > 0);
+    assert (str_compare ("track 9", "track 10") < 0);
+    assert (str_compare ("track 10b", "track 10a") > 0);
+
+    assert (! strcmp (strstr_nocase_utf8 ("Hello World", "WORLD"), "World"));
+    assert (! strcmp (strstr_nocase_utf8 ("Caf\xc3\xa9 Music", "CAF\xc3\x89"), "Caf\xc3\xa9 Music"));
+    assert (! strstr_nocase_utf8 ("Hello World", "Worlds"));
+    /* U+212A KELVIN SIGN folds to ASCII 'k' */
+    assert (! strcmp (strstr_nocase_utf8 ("5 \xe2\x84\xaa", "k"), "\xe2\x84\xaa"));
+}
+
+struct SortItem
+{
+    int key, seq;
+    String name;
+};
+
+static void check_sorted (const Index<SortItem> & items, int len)
+{
+    assert (items.len () == len);
+
+    for (int i = 1; i < len; i ++)
+    {
+        assert (items[i - 1].key <= items[i].key);
+        if (items[i - 1].key == items[i].key)
+            assert (items[i - 1].seq < items[i].seq);  /* stable */
+    }
+
+    for (auto & item : items)
+        assert (str_to_int (item.name) == item.seq);
+}
+
+static void test_index_sort ()
+{
+    auto compare = [] (const SortItem & a, const SortItem & b)
+        { return a.key - b.key; };
+
+    static const int lens[] = {0, 1, 2, 11, 12, 13, 100, 1000, 100000};
+
+    srand (1234);
+
+    for (int len : lens)
+    {
+        for (int pattern = 0; pattern < 4; pattern ++)
+        {
+            for (bool parallel : {false, true})
+            {
+                Index<SortItem> items;
+
+                for (int i = 0; i < len; i ++)
+                {
+                    int key;
+                    switch (pattern)
+                    {
+                        case 0: key = rand () % 50; break;     /* many ties */
+                        case 1: key = rand (); break;          /* random */
+                        case 2: key = i; break;                /* sorted */
+                        default: key = len - i; break;         /* reversed */
+                    }
+
+                    items.append (SortItem {key, i, String (int_to_str (i))});
+                }
+
+                items.sort (compare, parallel);
+                check_sorted (items, len);
+            }
+        }
+    }
+}
+
+/* runs a stereo sine wave through <cascade> and returns the output amplitude
+ * relative to the input */
+static float eq_response (BiquadCascade & cascade, float freq)
+{
+    const int rate = 48000, frames = rate / 2;
+    Index<float> data;
+    data.resize (2 * frames);
+
+    for (int i = 0; i < frames; i ++)
+        data[2 * i] = data[2 * i + 1] = 0.1f * sinf (2 * (float) M_PI * freq * i / rate);
+
+    cascade.reset (2);
+    cascade.process (data.begin (), data.len ());
+
+    float peak = 0;
+    for (int i = frames / 2; i < frames; i ++)
+    {
+        assert (data[2 * i] == data[2 * i + 1]);
+        peak = aud::max (peak, fabsf (data[2 * i]));
+    }
+
+    return peak / 0.1f;
+}
+
+static bool near (float a, float b, float tolerance)
+    { return fabsf (a - b) < tolerance; }
+
+static void test_parametric_eq ()
+{
+    const float db6 = powf (10, 6 / 20.0f);
+    BiquadCascade cascade;
+
+    /* no bands, preamp only */
+    cascade.design (Index<EqBand> (), -6, 48000);
+    assert (near (eq_response (cascade, 1000), 1 / db6, 0.01f));
+
+    Index<EqBand> bands;
+    bands.append (EqBand {EqBandType::Peaking, 1000, 6, 1.0f});
+    cascade.design (bands, 0, 48000);
+    assert (near (eq_response (cascade, 1000), db6, 0.02f));
+    assert (near (eq_response (cascade, 50), 1, 0.05f));
+
+    /* the output is not delayed, whatever the buffer size */
+    float impulse[2] = {1, 1};
+    cascade.reset (2);
+    cascade.process (impulse, 2);
+    assert (impulse[0] > 1 && impulse[0] == impulse[1]);
+
+    /* five bands span two pipeline groups */
+    bands.clear ();
+    for (float freq : {100, 400, 1600, 6400, 12800})
+        bands.append (EqBand {EqBandType::Peaking, freq, 6, 4.0f});
+
+    cascade.design (bands, 0, 48000);
+    assert (near (eq_response (cascade, 1600), db6, 0.05f));
+    assert (near (eq_response (cascade, 100), db6, 0.05f));
+    assert (near (eq_response (cascade, 800), 1, 0.1f));
+
+    /* splitting the input into buffers of any size gives the same output */
+    Index<float> whole, split;
+    whole.resize (2 * 1000);
+    for (int i = 0; i < whole.len (); i ++)
+        whole[i] = sinf (i * 0.37f);
+
+    split.insert (whole.begin (), 0, whole.len ());
+    cascade.reset (2);
+    cascade.process (whole.begin (), whole.len ());
+    cascade.reset (2);
+    for (int at = 0, size = 2; at < split.len (); at += size, size += 2)
+        cascade.process (& split[at], aud::min (size, split.len () - at));
+
+    assert (! memcmp (whole.begin (), split.begin (), sizeof (float) * whole.len ()));
+
+    bands.clear ();
+    bands.append (EqBand {EqBandType::LowShelf, 200, 6, 0.707f});
+    bands.append (EqBand {EqBandType::HighShelf, 8000, -6, 0.707f});
+    cascade.design (bands, 0, 48000);
+    assert (near (eq_response (cascade, 30), db6, 0.05f));
+    assert (near (eq_response (cascade, 1500), 1, 0.05f));
+    assert (near (eq_response (cascade, 20000), 1 / db6, 0.05f));
+
+    /* flat bands cost nothing */
+    double gains[31] = {};
+    gains[17] = 6;
+    bands = aud_eq_graphic_bands (gains, 31);
+    assert (bands.len () == 31 && bands[17].freq == 1000);
+    cascade.design (bands, 0, 48000);
+    assert (near (eq_response (cascade, 1000), db6, 0.02f));
+
+    assert (! aud_eq_graphic_bands (gains, 12).len ());
+}
+
+static void test_log_freq ()
+{
+    float freq[256];
+    for (int i = 0; i < 256; i ++)
+        freq[i] = 0.001f + (i % 7) * 0.01f + 1.0f / (i + 1);
+
+    for (int bands : {1, 12, 20, 64, 255, 256})
+    {
+        float xscale[257], out[256];
+        Visualizer::compute_log_xscale (xscale, bands);
+        Visualizer::compute_log_freq (freq, out, bands);
+
+        for (int band = 0; band < bands; band ++)
+            assert (near (out[band], Visualizer::compute_freq_band (freq,
+             xscale, band, bands), 0.001f));
+    }
+}
+
 int main ()
 {
     test_audio_conversion ();
@@ -523,9 +965,15 @@ int main ()
     test_numeric_conversion ();
     test_filename_split ();
     test_tuple_formats ();
+    test_tuple_album ();
+    test_playlist_columns ();
     test_ringbuf ();
     test_stringbuf ();
     test_str_printf ();
+    test_string_kernels ();
+    test_index_sort ();
+    test_parametric_eq ();
+    test_log_freq ();
 
     return 0;
 }
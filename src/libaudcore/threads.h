@@ -23,6 +23,8 @@
 #include <libaudcore/templates.h>
 #include <libaudcore/tinylock.h>
 
+#include <stdint.h>
+
 #include <condition_variable>
 #include <mutex>
 #include <thread>
@@ -30,6 +32,65 @@
 namespace aud
 {
 
+#ifdef AUD_PROFILE_LOCKS
+/* Lock profiling (configure with --enable-lock-profile).  Each acquisition
+ * records the time spent waiting for and holding the lock, keyed by the source
+ * location of the call to take() (see aud_lock_profile_report()).  The lock
+ * objects are the same size either way; only code compiled with
+ * AUD_PROFILE_LOCKS defined is instrumented. */
+struct LockSite;
+
+LockSite * lock_site(const char * file, int line);
+int64_t lock_clock(); /* nanoseconds */
+void lock_acquired(LockSite * site, int64_t wait, bool contended);
+void lock_released(LockSite * site, int64_t held);
+
+/* like aud::owner, but recording wait and hold times */
+template<class T, void (T::*acquire)(), void (T::*release)()>
+class profiled_owner
+{
+public:
+    explicit profiled_owner(T * obj = nullptr, LockSite * site = nullptr)
+        : m_obj(obj), m_site(site)
+    {
+        if (m_obj)
+        {
+            int64_t begin = lock_clock();
+            (m_obj->*acquire)();
+            m_since = lock_clock();
+            /* spinlocks have no try-lock; count waits over 1 us instead */
+            lock_acquired(m_site, m_since - begin, m_since - begin >= 1000);
+        }
+    }
+    ~profiled_owner()
+    {
+        if (m_obj)
+        {
+            lock_released(m_site, lock_clock() - m_since);
+            (m_obj->*release)();
+        }
+    }
+
+    profiled_owner(profiled_owner && b)
+        : m_obj(b.m_obj), m_site(b.m_site), m_since(b.m_since)
+    {
+        b.m_obj = nullptr;
+    }
+    profiled_owner & operator=(profiled_owner && b)
+    {
+        return move_assign(*this, std::move(b));
+    }
+
+private:
+    T * m_obj;
+    LockSite * m_site;
+    int64_t m_since = 0;
+};
+
+#define AUD_LOCK_SITE                                                          \
+    const char * file = __builtin_FILE(), int line = __builtin_LINE()
+#endif
+
 /* A wrapper class around TinyLock, encouraging correct usage */
 class spinlock
 {
@@ -44,10 +105,18 @@ public:
     void lock() { tiny_lock(&m_lock); }
     void unlock() { tiny_unlock(&m_lock); }
 
+#ifdef AUD_PROFILE_LOCKS
+    typedef profiled_owner<spinlock, &spinlock::lock, &spinlock::unlock> holder;
+    holder take(AUD_LOCK_SITE) __attribute__((warn_unused_result))
+    {
+        return holder(this, lock_site(file, line));
+    }
+#else
     /* Scope-based lock ownership */
     typedef owner<spinlock, &spinlock::lock, &spinlock::unlock> holder;
     /* Convenience method for taking ownership of the lock */
     holder take() __attribute__((warn_unused_result)) { return holder(this); }
+#endif
 
 private:
     TinyLock m_lock = 0;
@@ -69,6 +138,22 @@ public:
     void lock_w() { tiny_lock_write(&m_lock); }
     void unlock_w() { tiny_unlock_write(&m_lock); }
 
+#ifdef AUD_PROFILE_LOCKS
+    typedef profiled_owner<spinlock_rw, &spinlock_rw::lock_r,
+                           &spinlock_rw::unlock_r>
+        reader;
+    typedef profiled_owner<spinlock_rw, &spinlock_rw::lock_w,
+                           &spinlock_rw::unlock_w>
+        writer;
+    reader read(AUD_LOCK_SITE) __attribute__((warn_unused_result))
+    {
+        return reader(this, lock_site(file, line));
+    }
+    writer write(AUD_LOCK_SITE) __attribute__((warn_unused_result))
+    {
+        return writer(this, lock_site(file, line));
+    }
+#else
     /* Scope-based lock ownership */
     typedef owner<spinlock_rw, &spinlock_rw::lock_r, &spinlock_rw::unlock_r>
         reader;
@@ -77,6 +162,7 @@ public:
     /* Convenience methods for taking ownership of the lock */
     reader read() __attribute__((warn_unused_result)) { return reader(this); }
     writer write() __attribute__((warn_unused_result)) { return writer(this); }
+#endif
 
 private:
     TinyRWLock m_lock = 0;
@@ -86,14 +172,86 @@ private:
 class mutex : public std::mutex
 {
 public:
+#ifdef AUD_PROFILE_LOCKS
+    class holder : public std::unique_lock<std::mutex>
+    {
+    public:
+        holder() = default;
+        holder(aud::mutex & m, LockSite * site)
+            : unique_lock(m, std::defer_lock), m_site(site)
+        {
+            lock();
+        }
+        ~holder()
+        {
+            if (owns_lock())
+                unlock();
+        }
+
+        holder(holder && b) = default;
+        holder & operator=(holder && b)
+        {
+            if (owns_lock())
+                unlock();
+
+            unique_lock::operator=(std::move(b));
+            m_site = b.m_site;
+            m_since = b.m_since;
+            return *this;
+        }
+
+        void lock()
+        {
+            int64_t begin = lock_clock();
+            bool contended = !unique_lock::try_lock();
+            if (contended)
+                unique_lock::lock();
+
+            m_since = lock_clock();
+            lock_acquired(m_site, m_since - begin, contended);
+        }
+        void unlock()
+        {
+            lock_released(m_site, lock_clock() - m_since);
+            unique_lock::unlock();
+        }
+
+        /* a condvar wait releases the lock without going through unlock() */
+        void wait_begin() { lock_released(m_site, lock_clock() - m_since); }
+        void wait_end() { m_since = lock_clock(); }
+
+    private:
+        LockSite * m_site = nullptr;
+        int64_t m_since = 0;
+    };
+
+    holder take(AUD_LOCK_SITE) __attribute__((warn_unused_result))
+    {
+        return holder(*this, lock_site(file, line));
+    }
+#else
     /* Scope-based lock ownership */
     typedef std::unique_lock<std::mutex> holder;
     /* Convenience method for taking ownership of the lock */
     holder take() __attribute__((warn_unused_result)) { return holder(*this); }
+#endif
 };
 
+#ifdef AUD_PROFILE_LOCKS
+class condvar : public std::condition_variable
+{
+public:
+    void wait(mutex::holder & mh)
+    {
+        mh.wait_begin();
+        std::condition_variable::wait(mh);
+        mh.wait_end();
+    }
+};
+#else
 /* An alias for std::condition_variable */
 typedef std::condition_variable condvar;
+#endif
 
 } // namespace aud
 
@@ -29,6 +29,7 @@
 #include "audio.h"
 #include "audstrings.h"
 #include "i18n.h"
+#include "multihash.h"
 #include "tuple.h"
 #include "vfs.h"
 
@@ -53,14 +54,79 @@ union TupleVal {
     ~TupleVal() {}
 };
 
+static constexpr uint64_t bitmask(int n) { return (uint64_t)1 << n; }
+
+/* Fields which are usually identical for every track of an album.  These are
+ * kept in a separate block (AlbumData) which is shared between tuples. */
+static constexpr uint64_t album_fields =
+    bitmask(Tuple::Artist) | bitmask(Tuple::Album) |
+    bitmask(Tuple::AlbumArtist) | bitmask(Tuple::Genre) |
+    bitmask(Tuple::Year) | bitmask(Tuple::Copyright) | bitmask(Tuple::Date) |
+    bitmask(Tuple::AlbumGain) | bitmask(Tuple::AlbumPeak) |
+    bitmask(Tuple::GainDivisor) | bitmask(Tuple::PeakDivisor);
+
+static constexpr bool is_album_field(int field)
+{
+    return (album_fields & bitmask(field));
+}
+
+/* A set of field values, stored compactly in field order. */
+struct TupleFields
+{
+    uint64_t setmask;     // which fields are present
+    Index<TupleVal> vals; // ordered list of field values
+
+    TupleFields() : setmask(0) {}
+    ~TupleFields();
+
+    TupleFields(const TupleFields & other);
+    void operator=(const TupleFields & other) = delete;
+
+    bool is_set(int field) const { return (setmask & bitmask(field)); }
+    bool is_same(const TupleFields & other) const;
+    unsigned hash() const;
+
+    /* does not handle fallbacks; see TupleData::lookup() */
+    TupleVal * lookup(int field, bool add, bool remove);
+};
+
+/* Album-scoped fields, shared by reference between tuples.  Once a tuple is
+ * marked valid, its album block is interned in a global table, so that all the
+ * tracks of an album end up pointing to the same AlbumData.  An interned block
+ * is never modified; a tuple that needs to change one of its album fields gets
+ * a private copy instead (copy-on-write).  The reference count is stored in
+ * the "refs" member of the hash node. */
+struct AlbumData : public MultiHash::Node
+{
+    TupleFields fields;
+    bool interned;
+
+    AlbumData() : interned(false) { refs = 1; }
+    AlbumData(const AlbumData & other) : fields(other.fields), interned(false)
+    {
+        refs = 1;
+    }
+
+    bool match(const AlbumData * other) const
+    {
+        return other == this || fields.is_same(other->fields);
+    }
+
+    static AlbumData * ref(AlbumData * album);
+    static void unref(AlbumData * album);
+
+    static AlbumData * copy_on_write(AlbumData * album);
+    static AlbumData * intern(AlbumData * album);
+};
+
 /**
  * Structure for holding and passing around miscellaneous track
  * metadata. This is not the same as a playlist entry, though.
  */
 struct TupleData
 {
-    uint64_t setmask;     // which fields are present
-    Index<TupleVal> vals; // ordered list of field values
+    TupleFields fields; // track-scoped fields
+    AlbumData * album;  // album-scoped fields (may be null)
 
     short * subtunes; /**< Array of int containing subtune index numbers.
                            Can be nullptr if indexing is linear or if
@@ -78,7 +144,11 @@ struct TupleData
     TupleData(const TupleData & other);
     void operator=(const TupleData & other) = delete;
 
-    bool is_set(int field) const { return (setmask & bitmask(field)); }
+    bool is_set(int field) const
+    {
+        return is_album_field(field) ? (album && album->fields.is_set(field))
+                                     : fields.is_set(field);
+    }
 
     bool is_same(const TupleData & other);
 
@@ -91,9 +161,6 @@ struct TupleData
     static void unref(TupleData * tuple);
 
     static TupleData * copy_on_write(TupleData * tuple);
-
-private:
-    static constexpr uint64_t bitmask(int n) { return (uint64_t)1 << n; }
 };
 
 /** Ordered table of basic #Tuple field names and their #ValueType.
@@ -242,7 +309,7 @@ EXPORT Tuple::ValueType Tuple::field_get_type(Field field)
     return field_info[field].type;
 }
 
-TupleVal * TupleData::lookup(int field, bool add, bool remove)
+TupleVal * TupleFields::lookup(int field, bool add, bool remove)
 {
     /* calculate number of preceding fields */
     const uint64_t mask = bitmask(field);
@@ -263,9 +330,6 @@ TupleVal * TupleData::lookup(int field, bool add, bool remove)
         return &vals[pos];
     }
 
-    if (!(add || remove) && field_info[field].fallback >= 0)
-        return lookup(field_info[field].fallback, false, false);
-
     if (!add)
         return nullptr;
 
@@ -274,41 +338,7 @@ TupleVal * TupleData::lookup(int field, bool add, bool remove)
     return &vals[pos];
 }
 
-void TupleData::set_int(int field, int x)
-{
-    TupleVal * val = lookup(field, true, false);
-    val->x = x;
-}
-
-void TupleData::set_str(int field, const char * str)
-{
-    TupleVal * val = lookup(field, true, false);
-    new (&val->str) String(str);
-}
-
-void TupleData::set_subtunes(short nsubs, const short * subs)
-{
-    nsubtunes = nsubs;
-
-    delete[] subtunes;
-    subtunes = nullptr;
-
-    if (nsubs && subs)
-    {
-        subtunes = new short[nsubs];
-        memcpy(subtunes, subs, sizeof subtunes[0] * nsubs);
-    }
-}
-
-TupleData::TupleData()
-    : setmask(0), subtunes(nullptr), nsubtunes(0), state(Tuple::Initial),
-      refcount(1)
-{
-}
-
-TupleData::TupleData(const TupleData & other)
-    : setmask(other.setmask), subtunes(nullptr), nsubtunes(0),
-      state(other.state), refcount(1)
+TupleFields::TupleFields(const TupleFields & other) : setmask(other.setmask)
 {
     vals.insert(0, other.vals.len());
 
@@ -328,11 +358,9 @@ TupleData::TupleData(const TupleData & other)
             set++;
         }
     }
-
-    set_subtunes(other.nsubtunes, other.subtunes);
 }
 
-TupleData::~TupleData()
+TupleFields::~TupleFields()
 {
     auto iter = vals.begin();
 
@@ -346,14 +374,11 @@ TupleData::~TupleData()
             iter++;
         }
     }
-
-    delete[] subtunes;
 }
 
-bool TupleData::is_same(const TupleData & other)
+bool TupleFields::is_same(const TupleFields & other) const
 {
-    if (state != other.state || setmask != other.setmask ||
-        nsubtunes != other.nsubtunes || (!subtunes) != (!other.subtunes))
+    if (setmask != other.setmask)
         return false;
 
     auto a = vals.begin();
@@ -368,7 +393,7 @@ bool TupleData::is_same(const TupleData & other)
             if (field_info[f].type == Tuple::String)
                 same = (a->str == b->str);
             else
-                same = (a->x = b->x);
+                same = (a->x == b->x);
 
             if (!same)
                 return false;
@@ -378,6 +403,232 @@ bool TupleData::is_same(const TupleData & other)
         }
     }
 
+    return true;
+}
+
+unsigned TupleFields::hash() const
+{
+    unsigned h = setmask ^ (setmask >> 32);
+    auto iter = vals.begin();
+
+    for (int f = 0; f < n_private_fields; f++)
+    {
+        if (setmask & bitmask(f))
+        {
+            if (field_info[f].type == Tuple::String)
+                h = h * 31 + iter->str.hash();
+            else
+                h = h * 31 + (unsigned)iter->x;
+
+            iter++;
+        }
+    }
+
+    /* spread the bits, since MultiHash selects a channel by the high byte */
+    return h * 0x9e3779b1;
+}
+
+static MultiHash_T<AlbumData, AlbumData> album_table;
+
+struct AlbumGetter
+{
+    AlbumData * album;
+
+    AlbumData * add(const AlbumData *)
+    {
+        album->interned = true;
+        return album;
+    }
+
+    bool found(AlbumData * node)
+    {
+        __sync_fetch_and_add(&node->refs, 1);
+        album = node;
+        return false;
+    }
+};
+
+struct AlbumRemover
+{
+    AlbumData * add(const AlbumData *) { return nullptr; }
+
+    bool found(AlbumData * node)
+    {
+        if (!__sync_bool_compare_and_swap(&node->refs, 1, 0))
+            return false;
+
+        delete node;
+        return true;
+    }
+};
+
+AlbumData * AlbumData::ref(AlbumData * album)
+{
+    if (album)
+        __sync_fetch_and_add(&album->refs, 1);
+
+    return album;
+}
+
+void AlbumData::unref(AlbumData * album)
+{
+    if (!album)
+        return;
+
+    if (!album->interned)
+    {
+        if (!__sync_sub_and_fetch(&album->refs, 1))
+            delete album;
+
+        return;
+    }
+
+    /* an interned block must be removed from the table under lock, in case
+     * another thread is looking it up at the same time (cf. strpool.cc) */
+    while (1)
+    {
+        unsigned refs = __sync_fetch_and_add(&album->refs, 0);
+        if (refs > 1)
+        {
+            if (__sync_bool_compare_and_swap(&album->refs, refs, refs - 1))
+                break;
+        }
+        else
+        {
+            AlbumRemover op;
+            int status = album_table.lookup(album, album->hash, op);
+            if (!(status & MultiHash::Found))
+                throw std::bad_alloc();
+            if (status & MultiHash::Removed)
+                break;
+        }
+    }
+}
+
+AlbumData * AlbumData::copy_on_write(AlbumData * album)
+{
+    if (!album)
+        return new AlbumData;
+
+    if (!album->interned && __sync_fetch_and_add(&album->refs, 0) == 1)
+        return album;
+
+    AlbumData * copy = new AlbumData(*album);
+    unref(album);
+    return copy;
+}
+
+/* Replaces <album> with the equivalent block from the global table, adding it
+ * to the table if not already present.  Takes ownership of <album>; returns a
+ * new reference. */
+AlbumData * AlbumData::intern(AlbumData * album)
+{
+    if (!album || album->interned)
+        return album;
+
+    /* a block shared with another tuple cannot be added to the table as-is,
+     * since the other tuple may still modify it in place */
+    if (__sync_fetch_and_add(&album->refs, 0) != 1)
+    {
+        AlbumData * copy = new AlbumData(*album);
+        unref(album);
+        album = copy;
+    }
+
+    AlbumGetter op = {album};
+    album_table.lookup(album, album->fields.hash(), op);
+
+    if (op.album != album)
+        unref(album);
+
+    return op.album;
+}
+
+TupleVal * TupleData::lookup(int field, bool add, bool remove)
+{
+    TupleVal * val;
+
+    if (is_album_field(field))
+    {
+        if (add || (remove && is_set(field)))
+            album = AlbumData::copy_on_write(album);
+
+        val = album ? album->fields.lookup(field, add, remove) : nullptr;
+
+        if (remove && album && !album->fields.setmask)
+        {
+            AlbumData::unref(album);
+            album = nullptr;
+        }
+    }
+    else
+        val = fields.lookup(field, add, remove);
+
+    if (!val && !(add || remove) && field_info[field].fallback >= 0)
+        return lookup(field_info[field].fallback, false, false);
+
+    return val;
+}
+
+void TupleData::set_int(int field, int x)
+{
+    TupleVal * val = lookup(field, true, false);
+    val->x = x;
+}
+
+void TupleData::set_str(int field, const char * str)
+{
+    TupleVal * val = lookup(field, true, false);
+    new (&val->str) String(str);
+}
+
+void TupleData::set_subtunes(short nsubs, const short * subs)
+{
+    nsubtunes = nsubs;
+
+    delete[] subtunes;
+    subtunes = nullptr;
+
+    if (nsubs && subs)
+    {
+        subtunes = new short[nsubs];
+        memcpy(subtunes, subs, sizeof subtunes[0] * nsubs);
+    }
+}
+
+TupleData::TupleData()
+    : album(nullptr), subtunes(nullptr), nsubtunes(0), state(Tuple::Initial),
+      refcount(1)
+{
+}
+
+TupleData::TupleData(const TupleData & other)
+    : fields(other.fields), album(AlbumData::ref(other.album)),
+      subtunes(nullptr), nsubtunes(0), state(other.state), refcount(1)
+{
+    set_subtunes(other.nsubtunes, other.subtunes);
+}
+
+TupleData::~TupleData()
+{
+    AlbumData::unref(album);
+    delete[] subtunes;
+}
+
+bool TupleData::is_same(const TupleData & other)
+{
+    if (state != other.state || nsubtunes != other.nsubtunes ||
+        (!subtunes) != (!other.subtunes))
+        return false;
+
+    if (!fields.is_same(other.fields))
+        return false;
+
+    /* interned album blocks can be compared by address */
+    if (album != other.album &&
+        (!album || !other.album || !album->fields.is_same(other.album->fields)))
+        return false;
+
     if (subtunes &&
         memcmp(subtunes, other.subtunes, sizeof subtunes[0] * nsubtunes))
         return false;
@@ -432,6 +683,17 @@ EXPORT Tuple Tuple::ref() const
     return tuple;
 }
 
+EXPORT bool Tuple::same_album(const Tuple & b) const
+{
+    /* fast path: tracks sharing an interned album block */
+    if (data && b.data && data->album && data->album == b.data->album &&
+        data->album->fields.is_set(Album))
+        return true;
+
+    ::String album = get_str(Album);
+    return (album && album == b.get_str(Album));
+}
+
 EXPORT Tuple::State Tuple::state() const
 {
     return data ? (Tuple::State)data->state : Initial;
@@ -441,6 +703,11 @@ EXPORT void Tuple::set_state(State st)
 {
     data = TupleData::copy_on_write(data);
     data->state = st;
+
+    /* the tuple is now complete, so share its album fields with other tracks
+     * from the same album */
+    if (st == Valid)
+        data->album = AlbumData::intern(data->album);
 }
 
 EXPORT Tuple::ValueType Tuple::get_value_type(Field field) const
@@ -138,6 +138,10 @@ public:
 
     Tuple ref() const;
 
+    /* Returns true if both tuples have the same (non-empty) album name.  This
+     * is a simple pointer comparison for valid tuples from the same album. */
+    bool same_album(const Tuple & b) const;
+
     /* Gets/sets the state of the song info.  Before setting the state to Valid,
      * you should ensure that, at a minimum, set_filename() has been called. */
     State state() const;
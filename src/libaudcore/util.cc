@@ -29,6 +29,8 @@
 #include <glib/gstdio.h>
 
 #include "audstrings.h"
+#include "multihash.h"
+#include "objects.h"
 #include "runtime.h"
 #include "threads.h"
 
@@ -201,3 +203,105 @@ EXPORT float Visualizer::compute_freq_band(const float * freq,
 
     return 20 * log10f(n);
 }
+
+/* four lanes, using the GCC/Clang vector extensions (SSE, NEON, etc.) */
+typedef float Vec __attribute__((vector_size(16)));
+
+/* The weights applied by compute_freq_band() to each bin of the spectrum,
+ * stored per band as a run of consecutive bins.  Each run is padded with zero
+ * weights to a multiple of four bins, so that it can be summed four at a time. */
+struct BandMap
+{
+    Index<int> first_bin;  /* per band */
+    Index<int> weight_pos; /* per band, plus one past the end */
+    Index<float> weights;
+};
+
+static BandMap * build_band_map(int bands)
+{
+    auto map = new BandMap;
+    Index<float> xscale;
+
+    xscale.insert(0, bands + 1);
+    Visualizer::compute_log_xscale(xscale.begin(), bands);
+
+    for (int band = 0; band < bands; band++)
+    {
+        float w[256] = {};
+        int a = ceilf(xscale[band]);
+        int b = floorf(xscale[band + 1]);
+        int lo, hi;
+
+        /* same weights as in compute_freq_band() */
+        if (b < a)
+        {
+            lo = hi = b;
+            w[b] = xscale[band + 1] - xscale[band];
+        }
+        else
+        {
+            lo = aud::max(a - 1, 0);
+            hi = aud::min(b, 255);
+
+            if (a > 0)
+                w[a - 1] = a - xscale[band];
+            for (int i = a; i < b; i++)
+                w[i] = 1;
+            if (b < 256)
+                w[b] = xscale[band + 1] - b;
+        }
+
+        int count = (hi - lo + 4) & ~3;
+        lo = aud::min(lo, 256 - count);
+
+        map->first_bin.append(lo);
+        map->weight_pos.append(map->weights.len());
+        map->weights.insert(w + lo, -1, count);
+    }
+
+    map->weight_pos.append(map->weights.len());
+    return map;
+}
+
+static const BandMap * get_band_map(int bands)
+{
+    static aud::mutex mutex;
+    static SimpleHash<IntHashKey, SmartPtr<BandMap>> maps;
+
+    auto mh = mutex.take();
+
+    SmartPtr<BandMap> * map = maps.lookup(bands);
+    if (!map)
+        map = maps.add(bands, SmartPtr<BandMap>(build_band_map(bands)));
+
+    return map->get();
+}
+
+EXPORT void Visualizer::compute_log_freq(const float * freq, float * out,
+                                         int bands)
+{
+    if (bands < 1 || bands > 256)
+        return;
+
+    const BandMap * map = get_band_map(bands);
+    float fudge = (float)bands / 12;
+
+    for (int band = 0; band < bands; band++)
+    {
+        const float * f = freq + map->first_bin[band];
+        const float * w = &map->weights[map->weight_pos[band]];
+        int count = map->weight_pos[band + 1] - map->weight_pos[band];
+
+        Vec sum = {};
+        for (int i = 0; i < count; i += 4)
+        {
+            Vec fv, wv;
+            memcpy(&fv, f + i, sizeof fv);
+            memcpy(&wv, w + i, sizeof wv);
+            sum += fv * wv;
+        }
+
+        float n = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+        out[band] = 20 * log10f(n * fudge);
+    }
+}
@@ -29,6 +29,7 @@
 #include "internal.h"
 #include "plugin.h"
 #include "plugins-internal.h"
+#include "prefetch.h"
 #include "probe-buffer.h"
 #include "runtime.h"
 #include "vfs_local.h"
@@ -80,6 +81,17 @@ static TransportPlugin * lookup_transport(const char * filename, String & error,
     return nullptr;
 }
 
+/* opens a file through its transport, bypassing the prefetch cache */
+VFSImpl * vfs_transport_open(const char * filename, const char * mode,
+                             String & error)
+{
+    auto tp = lookup_transport(filename, error);
+    if (!tp)
+        return nullptr;
+
+    return tp->fopen(strip_subtune(filename), mode, error);
+}
+
 /**
  * Opens a stream from a VFS transport using one of the registered
  * #VFSConstructor handlers.
@@ -90,16 +102,21 @@ static TransportPlugin * lookup_transport(const char * filename, String & error,
  */
 EXPORT VFSFile::VFSFile(const char * filename, const char * mode)
 {
-    auto tp = lookup_transport(filename, m_error);
-    if (!tp)
-        return;
+    bool read_only = (mode[0] == 'r' && !strchr(mode, '+'));
+    VFSImpl * impl = nullptr;
+
+    if (read_only)
+        impl = prefetch_open(filename);
+    else
+        prefetch_invalidate(filename);
 
-    VFSImpl * impl = tp->fopen(strip_subtune(filename), mode, m_error);
+    if (!impl)
+        impl = vfs_transport_open(filename, mode, m_error);
     if (!impl)
         return;
 
     /* enable buffering for read-only handles */
-    if (mode[0] == 'r' && !strchr(mode, '+'))
+    if (read_only)
         impl = new ProbeBuffer(filename, impl);
 
     AUDINFO("<%p> open (mode %s) %s\n", impl, mode, filename);
@@ -281,42 +298,53 @@ EXPORT void VFSFile::set_limit_to_buffer(bool limit)
         AUDERR("<%p> buffering not supported!\n", m_impl.get());
 }
 
-EXPORT Index<char> VFSFile::read_all()
+EXPORT bool VFSFile::read_chunks(VFSChunkFunc func, void * user,
+                                 int chunk_size)
 {
-    constexpr int maxbuf = 16777216;
-    constexpr int pagesize = 4096;
-
     Index<char> buf;
-    int64_t size = fsize();
-    int64_t pos = ftell();
+    buf.resize(chunk_size);
 
-    if (size >= 0 && pos >= 0 && pos <= size)
+    while (1)
     {
-        buf.insert(0, aud::min(size - pos, (int64_t)maxbuf));
-        size = fread(buf.begin(), 1, buf.len());
+        int64_t readsize = fread(buf.begin(), 1, chunk_size);
+
+        if (readsize > 0 && !func(buf.begin(), readsize, user))
+            return false;
+
+        if (readsize < chunk_size)
+            return feof();
     }
-    else
-    {
-        size = 0;
+}
 
-        buf.insert(0, pagesize);
+static constexpr int read_all_max = 16777216;
 
-        int64_t readsize;
-        while ((readsize = fread(&buf[size], 1, buf.len() - size)))
-        {
-            size += readsize;
+static bool read_all_cb(const char * data, int len, void * user)
+{
+    auto buf = (Index<char> *)user;
+    int room = read_all_max - buf->len();
 
-            if (size == buf.len())
-            {
-                if (buf.len() > maxbuf - pagesize)
-                    break;
+    buf->insert(data, -1, aud::min(len, room));
+    return len <= room;
+}
 
-                buf.insert(-1, pagesize);
-            }
-        }
-    }
+EXPORT Index<char> VFSFile::read_all()
+{
+    Index<char> buf;
+    int64_t size = fsize();
+    int64_t pos = ftell();
 
-    buf.remove(size, -1);
+    if (size >= 0 && pos >= 0 && pos <= size)
+    {
+        if (size - pos > read_all_max)
+            AUDWARN("%s: only the first %d bytes will be read\n",
+                    (const char *)m_filename, read_all_max);
+
+        buf.insert(0, aud::min(size - pos, (int64_t)read_all_max));
+        buf.remove(fread(buf.begin(), 1, buf.len()), -1);
+    }
+    else if (!read_chunks(read_all_cb, &buf) && buf.len() == read_all_max)
+        AUDWARN("%s: only the first %d bytes were read\n",
+                (const char *)m_filename, read_all_max);
 
     return buf;
 }
@@ -49,6 +49,10 @@ enum VFSReadOptions
     VFS_IGNORE_MISSING = (1 << 1)
 };
 
+/* receives each chunk read by VFSFile::read_chunks(); returning false stops
+ * the reading */
+typedef bool (*VFSChunkFunc)(const char * data, int len, void * user);
+
 enum VFSSeekType
 {
     VFS_SEEK_SET = 0,
@@ -158,9 +162,16 @@ public:
 
     /* utility functions */
 
-    /* reads the entire file into memory (limited to 16 MB) */
+    /* reads the entire file into memory (limited to 16 MB; a larger file is
+     * truncated with a warning) */
     Index<char> read_all();
 
+    /* reads the rest of the file in chunks of up to <chunk_size> bytes,
+     * passing each to <func>, so that large files can be parsed with bounded
+     * memory; returns true if the end of the file was reached, false on a
+     * read error or if <func> stopped the reading */
+    bool read_chunks(VFSChunkFunc func, void * user, int chunk_size = 65536);
+
     /* reads data from another open file and appends it to this one */
     bool copy_from(VFSFile & source, int64_t size = -1);
 
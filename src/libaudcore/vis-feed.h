@@ -0,0 +1,110 @@
+/*
+ * vis-feed.h
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef LIBAUDCORE_VIS_FEED_H
+#define LIBAUDCORE_VIS_FEED_H
+
+/*
+ * Layout of the visualization feed, a ring of audio frames published by the
+ * output thread.  In-process visualizers (see visualizer.h) read the feed from
+ * memory.  If "vis_shared_feed" is enabled in the config, the feed is also
+ * placed in a shared memory file, so that other processes can map it and read
+ * it at their own rate:
+ *
+ *     $XDG_RUNTIME_DIR/audacious-vis-<instance>  (instance is usually 1)
+ *
+ * This header has no dependencies, so that it can be copied into programs
+ * written in C.
+ *
+ * Each frame holds 512 frames of interleaved PCM and the spectrum of their mono
+ * mix, and is stamped with its stream time.  Frames are written every 33 ms of
+ * audio, ahead of playback by about the length of the output buffer.  To stay
+ * in sync, a reader should display the newest frame whose time is not later
+ * than the time currently being heard, which is:
+ *
+ *     output_time + (now - output_clock) / 1000   (if state is PLAYING)
+ *
+ * where "now" is read from CLOCK_MONOTONIC in microseconds.
+ *
+ * There is a single writer and no locking.  Instead, the frames and the pair
+ * (output_time, output_clock) are each guarded by a sequence number, which is
+ * odd while the guarded values are being written.  To read them, read the
+ * sequence number (acquire), copy the values, issue an acquire fence, then
+ * read the sequence number again; the copy is valid if both values are equal
+ * and even, otherwise retry.  output_time and output_clock must be read
+ * together in this way, since they are updated every 33 ms and a mismatched
+ * pair is off by one update.  Frames whose serial does not match the header's
+ * serial belong to a previous song (or were written before a seek) and should
+ * be ignored.
+ *
+ * If "closed" is set, the feed has been torn down (or resized); unmap it and
+ * open the file again later.
+ */
+
+#include <stdint.h>
+
+#define AUD_VIS_FEED_MAGIC 0x46536941 /* "AiSF" */
+#define AUD_VIS_FEED_VERSION 2
+
+#define AUD_VIS_FEED_FRAMES 512
+#define AUD_VIS_FEED_BANDS 256
+#define AUD_VIS_FEED_MAX_CHANNELS 10
+
+enum
+{
+    AUD_VIS_FEED_STOPPED = 0,
+    AUD_VIS_FEED_PLAYING = 1,
+    AUD_VIS_FEED_PAUSED = 2
+};
+
+struct AudVisFeedFrame
+{
+    uint32_t seq;
+    uint32_t serial;
+    int32_t time; /* stream time of the first sample, in milliseconds */
+    int32_t channels;
+    int32_t rate;
+    int32_t reserved;
+
+    /* intensity of frequencies 1/512, 2/512, ..., 256/512 of sample rate */
+    float freq[AUD_VIS_FEED_BANDS];
+    /* interleaved, <channels> values per frame */
+    float pcm[AUD_VIS_FEED_FRAMES * AUD_VIS_FEED_MAX_CHANNELS];
+};
+
+struct AudVisFeedHeader
+{
+    uint32_t magic, version;
+    uint32_t n_slots;    /* number of frames in the ring */
+    uint32_t frame_size; /* sizeof(struct AudVisFeedFrame) */
+    uint32_t closed;
+    uint32_t state; /* AUD_VIS_FEED_STOPPED, etc. */
+    uint32_t serial;
+    uint32_t time_seq;    /* sequence number of output_time and output_clock */
+    int32_t output_time;  /* stream time being heard, in milliseconds */
+    int32_t reserved;
+    int64_t output_clock; /* CLOCK_MONOTONIC (microseconds) of output_time */
+    uint64_t written;     /* frames written; the newest is (written - 1) mod
+                           * n_slots */
+    uint8_t padding[64 - 56];
+
+    /* followed by n_slots frames */
+};
+
+#endif /* LIBAUDCORE_VIS_FEED_H */
@@ -18,44 +18,223 @@
  */
 
 #include "internal.h"
+#include "vis-feed.h"
 
 #include <assert.h>
+#include <errno.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <glib.h> /* for g_get_monotonic_time, g_get_user_runtime_dir */
+
+#include "audstrings.h"
 #include "hook.h"
-#include "list.h"
 #include "mainloop.h"
 #include "output.h"
+#include "runtime.h"
 #include "threads.h"
 
 #define INTERVAL 33 /* milliseconds */
-#define FRAMES_PER_NODE 512
+#define FRAMES_PER_NODE AUD_VIS_FEED_FRAMES
+
+#define MIN_SLOTS 32
+#define MAX_SLOTS 512
+
+static_assert(AUD_VIS_FEED_MAX_CHANNELS == AUD_MAX_CHANNELS,
+              "channel limit mismatch");
+static_assert(sizeof(AudVisFeedHeader) == 64, "feed header size changed");
 
-struct VisNode : public ListNode
+/* The audio passed in by the output thread is cut into frames, which are
+ * published in the feed (see vis-feed.h).  The feed is read by a timer on the
+ * main thread, which passes the frame currently being heard to the in-process
+ * visualizers, and optionally by other processes through shared memory. */
+
+struct Feed
 {
-    VisNode(int channels, int time)
-        : channels(channels), time(time),
-          data(new float[channels * FRAMES_PER_NODE])
+    AudVisFeedHeader * header = nullptr;
+    size_t size = 0;
+    String path; /* set if shared */
+
+    AudVisFeedFrame * frame(uint64_t n)
     {
+        return (AudVisFeedFrame *)(header + 1) + n % header->n_slots;
     }
-
-    ~VisNode() { delete[] data; }
-
-    const int channels;
-    int time;
-    float * data;
 };
 
 static aud::mutex mutex;
-static bool enabled = false;
+static bool local_enabled = false, shared_enabled = false;
 static bool playing = false, paused = false;
-static VisNode * current_node = nullptr;
-static int current_frames;
-static List<VisNode> vis_list;
-static List<VisNode> vis_pool;
+static Feed feed;
+
+/* frame being built by the output thread */
+static AudVisFeedFrame staging;
+static int current_frames = -1; /* -1 if no frame is being built */
+static int next_time = -1;      /* time of the next frame, if continuing */
+
+/* last frame passed to the in-process visualizers */
+static uint64_t last_sent = 0;
+static AudVisFeedFrame reading;
+
 static QueuedFunc queued_clear;
 
+static inline uint32_t load_acquire(const uint32_t * p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void store_release(uint32_t * p, uint32_t val)
+{
+    __atomic_store_n(p, val, __ATOMIC_RELEASE);
+}
+
+static int needed_slots()
+{
+    /* frames are written ahead of playback by the length of the output
+     * buffer; allow an extra second for the output plugin's own buffer */
+    int ahead = aud_get_int("output_buffer_size") + 1000;
+    int slots = MIN_SLOTS;
+
+    while (slots < MAX_SLOTS && slots * INTERVAL < ahead)
+        slots *= 2;
+
+    return slots;
+}
+
+static void close_feed(aud::mutex::holder &)
+{
+    if (!feed.header)
+        return;
+
+    store_release(&feed.header->closed, 1);
+
+#ifndef _WIN32
+    if (feed.path)
+    {
+        munmap(feed.header, feed.size);
+        unlink(feed.path);
+    }
+    else
+#endif
+        free(feed.header);
+
+    feed = Feed();
+}
+
+#ifndef _WIN32
+static void * map_shared_file(const char * path, size_t size)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+    {
+        AUDERR("Failed to create %s: %s\n", path, strerror(errno));
+        return nullptr;
+    }
+
+    void * mem = MAP_FAILED;
+    if (ftruncate(fd, size) == 0)
+        mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (mem == MAP_FAILED)
+    {
+        AUDERR("Failed to map %s: %s\n", path, strerror(errno));
+        unlink(path);
+    }
+
+    close(fd);
+    return (mem != MAP_FAILED) ? mem : nullptr;
+}
+#endif
+
+static void open_feed(aud::mutex::holder & mh)
+{
+    int slots = needed_slots();
+    bool shared = shared_enabled;
+
+    if (feed.header &&
+        (feed.header->n_slots >= (unsigned)slots && !!feed.path == shared))
+        return;
+
+    close_feed(mh);
+
+    size_t size = sizeof(AudVisFeedHeader) + sizeof(AudVisFeedFrame) * slots;
+    void * mem = nullptr;
+
+#ifndef _WIN32
+    if (shared)
+    {
+        StringBuf path = filename_build(
+            {g_get_user_runtime_dir(),
+             str_printf("audacious-vis-%d", aud_get_instance())});
+
+        if ((mem = map_shared_file(path, size)))
+            feed.path = String(path);
+    }
+#endif
+
+    if (!mem)
+        mem = calloc(1, size);
+
+    feed.header = (AudVisFeedHeader *)mem;
+    feed.size = size;
+
+    /* mmap() and calloc() both return zeroed memory */
+    feed.header->magic = AUD_VIS_FEED_MAGIC;
+    feed.header->version = AUD_VIS_FEED_VERSION;
+    feed.header->n_slots = slots;
+    feed.header->frame_size = sizeof(AudVisFeedFrame);
+
+    last_sent = 0;
+}
+
+static void set_output_time(int time)
+{
+    AudVisFeedHeader * header = feed.header;
+
+    uint32_t seq = header->time_seq + 1; /* odd */
+    store_release(&header->time_seq, seq);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    header->output_time = time;
+    header->output_clock = g_get_monotonic_time();
+
+    store_release(&header->time_seq, seq + 1);
+}
+
+static void set_state(aud::mutex::holder &)
+{
+    if (!feed.header)
+        return;
+
+    uint32_t state = !playing ? AUD_VIS_FEED_STOPPED
+                     : paused ? AUD_VIS_FEED_PAUSED
+                              : AUD_VIS_FEED_PLAYING;
+
+    store_release(&feed.header->state, state);
+}
+
+/* copies a frame out of the feed, returning false if it was overwritten (or
+ * is being written) in the meantime */
+static bool read_frame(uint64_t n, AudVisFeedFrame & copy)
+{
+    AudVisFeedFrame * frame = feed.frame(n);
+
+    uint32_t seq = load_acquire(&frame->seq);
+    if (seq & 1)
+        return false;
+
+    memcpy(&copy, frame, sizeof copy);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    return load_acquire(&frame->seq) == seq;
+}
+
 static void send_audio(void *)
 {
     /* call before locking mutex to avoid deadlock */
@@ -63,49 +242,63 @@ static void send_audio(void *)
 
     auto mh = mutex.take();
 
-    if (!enabled || !playing || paused)
+    if (!feed.header || !playing || paused)
         return;
 
-    VisNode * node = nullptr;
-    VisNode * next;
+    set_output_time(outputted);
+
+    if (!local_enabled)
+        return;
 
-    while ((next = vis_list.head()))
+    /* Find the most recent frame that is not in the future.  If there is none,
+     * accept the oldest frame if it is not in the future by more than the
+     * length of an interval. */
+    AudVisFeedHeader * header = feed.header;
+    uint64_t written = header->written;
+    uint64_t oldest =
+        (written > header->n_slots) ? written - header->n_slots : 0;
+    bool found = false;
+
+    oldest = aud::max(oldest, last_sent);
+
+    for (uint64_t n = written; n > oldest; n--)
     {
-        /* If we are considering a node, stop searching and use it if it is the
-         * most recent (that is, the next one is in the future).  Otherwise,
-         * consider the next node if it is not in the future by more than the
-         * length of an interval. */
-        if (next->time > outputted + (node ? 0 : INTERVAL))
+        /* the output thread doesn't write while the mutex is held */
+        AudVisFeedFrame * frame = feed.frame(n - 1);
+        if (frame->serial != header->serial)
             break;
 
-        if (node)
-            vis_pool.prepend(node);
-
-        node = next;
-        vis_list.remove(node);
+        if (frame->time <= outputted ||
+            (n - 1 == oldest && frame->time <= outputted + INTERVAL))
+        {
+            found = read_frame(n - 1, reading);
+            last_sent = n;
+            break;
+        }
     }
 
-    if (!node)
+    if (!found)
         return;
 
     mh.unlock();
-    vis_send_audio(node->data, node->channels);
-    mh.lock();
-
-    vis_pool.prepend(node);
+    vis_send_audio(reading.pcm, reading.channels, reading.freq);
 }
 
 static void send_clear(void *) { vis_send_clear(); }
 
 static void flush(aud::mutex::holder &)
 {
-    delete current_node;
-    current_node = nullptr;
+    current_frames = -1;
+    next_time = -1;
 
-    vis_list.clear();
-    vis_pool.clear();
+    if (feed.header)
+    {
+        /* invalidates all frames in the feed */
+        store_release(&feed.header->serial, feed.header->serial + 1);
+        last_sent = feed.header->written;
+    }
 
-    if (enabled)
+    if (local_enabled)
         queued_clear.queue(send_clear, nullptr);
 }
 
@@ -118,14 +311,24 @@ void vis_runner_flush()
 static void start_stop(aud::mutex::holder & mh, bool new_playing,
                        bool new_paused)
 {
+    bool enabled = local_enabled || shared_enabled;
+    bool starting = (new_playing && !playing);
+
     playing = new_playing;
     paused = new_paused;
 
     queued_clear.stop();
 
+    if (!enabled)
+        close_feed(mh);
+    else if (!feed.header || starting)
+        open_feed(mh);
+
     if (!enabled || !playing)
         flush(mh);
 
+    set_state(mh);
+
     if (enabled && playing && !paused)
         timer_add(TimerRate::Hz30, send_audio);
     else
@@ -138,82 +341,138 @@ void vis_runner_start_stop(bool new_playing, bool new_paused)
     start_stop(mh, new_playing, new_paused);
 }
 
+static void publish_frame(int channels, int rate)
+{
+    AudVisFeedHeader * header = feed.header;
+    AudVisFeedFrame * frame = feed.frame(header->written);
+
+    /* mono mix for the spectrum */
+    float mono[FRAMES_PER_NODE];
+
+    if (channels == 1)
+        memcpy(mono, staging.pcm, sizeof mono);
+    else
+    {
+        const float * data = staging.pcm;
+        for (float & set : mono)
+        {
+            set = (data[0] + data[1]) / 2;
+            data += channels;
+        }
+    }
+
+    calc_freq(mono, staging.freq);
+
+    uint32_t seq = frame->seq + 1; /* odd */
+    store_release(&frame->seq, seq);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    frame->serial = header->serial;
+    frame->time = staging.time;
+    frame->channels = channels;
+    frame->rate = rate;
+
+    memcpy(frame->freq, staging.freq, sizeof frame->freq);
+    memcpy(frame->pcm, staging.pcm, sizeof(float) * channels * FRAMES_PER_NODE);
+
+    store_release(&frame->seq, seq + 1);
+    __atomic_store_n(&header->written, header->written + 1, __ATOMIC_RELEASE);
+}
+
 void vis_runner_pass_audio(int time, const Index<float> & data, int channels,
                            int rate)
 {
     auto mh = mutex.take();
 
-    if (!enabled || !playing)
+    if (!feed.header || !playing)
         return;
 
-    /* We can build a single node from multiple calls; we can also build
-     * multiple nodes from the same call.  If current_node is present, it was
-     * partly built in the last call and needs to be finished. */
+    /* We can build a single frame from multiple calls; we can also build
+     * multiple frames from the same call.  If current_frames is not -1, a frame
+     * was partly built in the last call and needs to be finished. */
 
     int at = 0;
 
     while (1)
     {
-        if (current_node)
-            assert(current_node->channels == channels);
+        if (current_frames >= 0)
+            assert(staging.channels == channels);
         else
         {
-            int node_time = time;
+            int frame_time = time;
 
-            /* There is no partly-built node, so start a new one.  Normally
-             * there will be nodes in the queue already; if so, we want to copy
-             * audio data from the signal starting at 30 milliseconds after the
-             * beginning of the most recent node.  If there are no nodes in the
-             * queue, we are at the beginning of the song or had an underrun,
-             * and we want to copy the earliest audio data we have. */
+            /* There is no partly-built frame, so start a new one.  Normally
+             * frames have been built already; if so, we want to copy audio data
+             * from the signal starting at 30 milliseconds after the beginning
+             * of the most recent frame.  If not, we are at the beginning of the
+             * song or had an underrun, and we want to copy the earliest audio
+             * data we have. */
 
-            VisNode * tail = vis_list.tail();
-            if (tail)
-                node_time = tail->time + INTERVAL;
+            if (next_time >= 0)
+                frame_time = next_time;
 
-            at = channels * (int)((int64_t)(node_time - time) * rate / 1000);
+            at = channels * (int)((int64_t)(frame_time - time) * rate / 1000);
 
             if (at < 0)
                 at = 0;
             if (at >= data.len())
                 break;
 
-            current_node = vis_pool.head();
-
-            if (current_node)
-            {
-                assert(current_node->channels == channels);
-                vis_pool.remove(current_node);
-                current_node->time = node_time;
-            }
-            else
-                current_node = new VisNode(channels, node_time);
-
+            staging.time = frame_time;
+            staging.channels = channels;
             current_frames = 0;
         }
 
         /* Copy as much data as we can, limited by how much we have and how much
-         * space is left in the node.  If we cannot fill the node, we return and
-         * wait for more data to be passed in the next call.  If we do fill the
-         * node, we loop and start building a new one. */
+         * space is left in the frame.  If we cannot fill the frame, we return
+         * and wait for more data to be passed in the next call.  If we do fill
+         * the frame, we loop and start building a new one. */
 
         int copy = aud::min(data.len() - at,
                             channels * (FRAMES_PER_NODE - current_frames));
-        memcpy(current_node->data + channels * current_frames, &data[at],
+        memcpy(staging.pcm + channels * current_frames, &data[at],
                sizeof(float) * copy);
         current_frames += copy / channels;
 
         if (current_frames < FRAMES_PER_NODE)
             break;
 
-        vis_list.append(current_node);
-        current_node = nullptr;
+        publish_frame(channels, rate);
+        next_time = staging.time + INTERVAL;
+        current_frames = -1;
     }
 }
 
 void vis_runner_enable(bool enable)
 {
     auto mh = mutex.take();
-    enabled = enable;
+    local_enabled = enable;
     start_stop(mh, playing, paused);
 }
+
+static void shared_changed(void *, void *)
+{
+    auto mh = mutex.take();
+    shared_enabled = aud_get_bool("vis_shared_feed");
+
+    /* reopen the feed in the right kind of memory */
+    if (feed.header)
+        close_feed(mh);
+
+    start_stop(mh, playing, paused);
+}
+
+void vis_runner_init()
+{
+    shared_changed(nullptr, nullptr);
+    hook_associate("set vis_shared_feed", shared_changed, nullptr);
+}
+
+void vis_runner_cleanup()
+{
+    hook_dissociate("set vis_shared_feed", shared_changed);
+
+    auto mh = mutex.take();
+    local_enabled = shared_enabled = false;
+    start_stop(mh, false, false);
+}
@@ -80,7 +80,7 @@ static void pcm_to_mono(const float * data, float * mono, int channels)
     }
 }
 
-void vis_send_audio(const float * data, int channels)
+void vis_send_audio(const float * data, int channels, const float * freq)
 {
     auto is_active = [](int type_mask) {
         for (Visualizer * vis : visualizers)
@@ -93,12 +93,31 @@ void vis_send_audio(const float * data, int channels)
     };
 
     float mono[512];
-    float freq[256];
 
-    if (is_active(Visualizer::MonoPCM | Visualizer::Freq))
+    if (is_active(Visualizer::MonoPCM))
         pcm_to_mono(data, mono, channels);
-    if (is_active(Visualizer::Freq))
-        calc_freq(mono, freq);
+
+    /* log-scale bands are computed once for each band count in use */
+    struct LogFreqFrame
+    {
+        int bands;
+        float data[256];
+    };
+
+    Index<LogFreqFrame> log_freq;
+
+    auto get_log_freq = [&](int bands) -> const float * {
+        for (const LogFreqFrame & frame : log_freq)
+        {
+            if (frame.bands == bands)
+                return frame.data;
+        }
+
+        LogFreqFrame & frame = log_freq.append();
+        frame.bands = bands;
+        Visualizer::compute_log_freq(freq, frame.data, bands);
+        return frame.data;
+    };
 
     for (Visualizer * vis : visualizers)
     {
@@ -108,6 +127,9 @@ void vis_send_audio(const float * data, int channels)
             vis->render_multi_pcm(data, channels);
         if ((vis->type_mask & Visualizer::Freq))
             vis->render_freq(freq);
+        if ((vis->type_mask & Visualizer::LogFreq) && vis->log_bands > 0 &&
+            vis->log_bands <= 256)
+            vis->render_log_freq(get_log_freq(vis->log_bands));
     }
 }
 
@@ -29,11 +29,17 @@ public:
     {
         MonoPCM = (1 << 0),
         MultiPCM = (1 << 1),
-        Freq = (1 << 2)
+        Freq = (1 << 2),
+        LogFreq = (1 << 3)
     };
 
     const int type_mask;
-    constexpr Visualizer(int type_mask) : type_mask(type_mask) {}
+    const int log_bands; /* number of bands for render_log_freq() */
+
+    constexpr Visualizer(int type_mask, int log_bands = 0)
+        : type_mask(type_mask), log_bands(log_bands)
+    {
+    }
 
     /* reset internal state and clear display */
     virtual void clear() = 0;
@@ -51,6 +57,15 @@ public:
     static void compute_log_xscale(float * xscale, int bands);
     static float compute_freq_band(const float * freq, const float * xscale,
                                    int band, int bands);
+
+    /* computes all <bands> bands of a log-scale frequency graph at once, the
+     * same as compute_freq_band() would, using a cached band mapping */
+    static void compute_log_freq(const float * freq, float * out, int bands);
+
+    /* intensity of <log_bands> log-scale frequency bands, in decibels, as
+     * returned by compute_log_freq(); the bands are computed once per frame
+     * and shared by all visualizers using the same number of bands */
+    virtual void render_log_freq(const float * bands) {}
 };
 
 #endif /* LIBAUDCORE_VISUALIZER_H */
@@ -51,6 +51,9 @@ struct ValuePair {
 #define APE_FLAG_HAS_NO_FOOTER (1 << 30)
 #define APE_FLAG_IS_HEADER (1 << 29)
 
+#define APE_ITEM_TYPE_MASK (3 << 1)
+#define APE_ITEM_TEXT (0 << 1)
+
 namespace audtag {
 
 static bool ape_read_header (VFSFile & handle, APEHeader * header)
@@ -171,42 +174,67 @@ bool APETagModule::can_handle_file (VFSFile & handle)
      & data_length);
 }
 
-/* returns start of next item or nullptr */
-static const char * ape_read_item (const char * data, int length, ValuePair & pair)
+/* reads the item at the current position, <remain> being the number of bytes
+ * left in the tag; with <text_only>, binary items (such as cover art) are
+ * skipped over rather than read into memory, and <pair.value> is left null */
+static bool ape_read_item (VFSFile & handle, int & remain, bool text_only,
+ ValuePair & pair)
 {
-    auto header = (const uint32_t *) data;
-    const char * value;
+    uint32_t header[2];
+    char key[256]; /* keys are limited to 255 characters */
 
-    if (length < 8)
+    if (remain < 8)
     {
-        AUDWARN ("Expected item, but only %d bytes remain in tag.\n", length);
-        return nullptr;
+        AUDWARN ("Expected item, but only %d bytes remain in tag.\n", remain);
+        return false;
     }
 
-    value = (const char *) memchr (data + 8, 0, length - 8);
+    if (handle.fread (header, 1, 8) != 8)
+        return false;
 
-    if (! value)
+    int value_length = FROM_LE32 (header[0]);
+    int flags = FROM_LE32 (header[1]);
+    remain -= 8;
+
+    int key_read = handle.fread (key, 1, aud::min (remain, (int) sizeof key));
+    auto key_end = (const char *) memchr (key, 0, aud::max (key_read, 0));
+
+    if (! key_end)
     {
-        AUDWARN ("Unterminated item key (max length = %d).\n", length - 8);
-        return nullptr;
+        AUDWARN ("Unterminated item key (max length = %d).\n", aud::min (remain, (int) sizeof key));
+        return false;
     }
 
-    value ++;
+    int key_length = key_end + 1 - key;
+    remain -= key_length;
 
-    if (header[0] > (unsigned) (data + length - value))
+    if (value_length < 0 || value_length > remain)
     {
         AUDWARN ("Item value of length %d, but only %d bytes remain in tag.\n",
-         (int) header[0], (int) (data + length - value));
-        return nullptr;
+         value_length, remain);
+        return false;
     }
 
-    pair.key = String (data + 8);
-    pair.value = String (str_copy (value, header[0]));
+    pair.key = String (key);
+    remain -= value_length;
+
+    if (text_only && (flags & APE_ITEM_TYPE_MASK) != APE_ITEM_TEXT)
+        return ! handle.fseek (key_length + value_length - key_read, VFS_SEEK_CUR);
+
+    if (handle.fseek (key_length - key_read, VFS_SEEK_CUR))
+        return false;
+
+    StringBuf value (value_length);
+    if (handle.fread (value, 1, value_length) != value_length)
+        return false;
 
-    return value + header[0];
+    pair.value = String (value);
+    return true;
 }
 
-static Index<ValuePair> ape_read_items (VFSFile & handle)
+/* items are read one at a time, so memory use is bounded by the largest item
+ * (or the largest text item, with <text_only>) rather than the whole tag */
+static Index<ValuePair> ape_read_items (VFSFile & handle, bool text_only)
 {
     Index<ValuePair> list;
     APEHeader header;
@@ -218,21 +246,21 @@ static Index<ValuePair> ape_read_items (VFSFile & handle)
     if (handle.fseek (data_start, VFS_SEEK_SET))
         return list;
 
-    Index<char> data;
-    data.insert (0, data_length);
-
-    if (handle.fread (data.begin (), 1, data_length) != data_length)
-        return list;
-
     AUDDBG ("Reading %d items:\n", header.items);
-    const char * item = data.begin ();
+    int remain = data_length;
 
     while (header.items --)
     {
         ValuePair pair;
-        if (! (item = ape_read_item (item, data.end () - item, pair)))
+        if (! ape_read_item (handle, remain, text_only, pair))
             break;
 
+        if (! pair.value)
+        {
+            AUDDBG ("Skipped: %s.\n", (const char *) pair.key);
+            continue;
+        }
+
         AUDDBG ("Read: %s = %s.\n", (const char *) pair.key, (const char *) pair.value);
         list.append (std::move (pair));
     }
@@ -242,7 +270,7 @@ static Index<ValuePair> ape_read_items (VFSFile & handle)
 
 bool APETagModule::read_tag (VFSFile & handle, Tuple & tuple, Index<char> * image)
 {
-    Index<ValuePair> list = ape_read_items (handle);
+    Index<ValuePair> list = ape_read_items (handle, true);
 
     for (const ValuePair & pair : list)
     {
@@ -347,7 +375,7 @@ static bool write_header (int data_length, int items, bool is_header,
 
 bool APETagModule::write_tag (VFSFile & handle, const Tuple & tuple)
 {
-    Index<ValuePair> list = ape_read_items (handle);
+    Index<ValuePair> list = ape_read_items (handle, false);
     APEHeader header;
     int start, length, data_start, data_length, items;
 